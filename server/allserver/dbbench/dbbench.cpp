@@ -0,0 +1,618 @@
+// dbbench.cpp : dbserverѹԣģϷͻ
+//
+// ѹÿͻ˰̶źʱ䣬ӳٴӼƻʱ
+// ˱ʱΪͻ˵ȴٷ󣬱Э©coordinated omission
+//
+
+#include "stdafx.h"
+#include "XIoPort.h"
+#include "XHistogram.h"
+#include "DBProtocol.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+
+#ifdef _WIN32
+#	include <ws2tcpip.h>
+#else
+#	include <netdb.h>
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	define INVALID_SOCKET		((SOCKET)(~0))
+#	define closesocket(s)		close((int)(s))
+#endif
+
+XMemCache<XAtomMutex>*	g_pMemCache = nullptr;
+
+#if XCORO_SUPPORTED
+
+//-----------------------------------------------------------------------------
+// Բ
+//-----------------------------------------------------------------------------
+struct tagBenchConfig
+{
+	const char*			szHost;
+	const char*			szPort;
+	int					nClients;		// 
+	int					nRate;			// /
+	int					nDuration;		// ͳʱ
+	int					nWarmup;		// Ԥʱ룬ͳ
+	int					nThreads;		// IO߳
+	int					nRead;			// ¼ٷֱ
+	int					nWrite;			// д¼ٷֱȣʣµа
+	unsigned long long	qwKeys;			// key
+	double				dTheta;			// Zipf0Ϊȷֲ
+	DWORD				dwMinSize;		// ¼С
+	DWORD				dwMaxSize;
+	unsigned int		dwSeed;
+	const char*			szHdrFile;		// ٷλֲļǰ׺
+};
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+enum
+{
+	OP_GET,
+	OP_PUT,
+	OP_RANK_SET,
+	OP_RANK_GET,
+	OP_RANK_TOP,
+	OP_RANK_AROUND,
+	OP_NUM,
+};
+
+static const char* g_szOpName[OP_NUM] = { "get", "put", "rank_set", "rank_get", "rank_top", "rank_around" };
+static const WORD g_wOpType[OP_NUM] = { DB_MSG_GET, DB_MSG_PUT, DB_MSG_RANK_SET, DB_MSG_RANK_GET, DB_MSG_RANK_TOP, DB_MSG_RANK_AROUND };
+
+static XHistogram		g_Histogram[OP_NUM];	// ӳ٣΢
+static LONG volatile	g_lErrors = 0;
+static LONG volatile	g_lClients = 0;			// еĿͻ
+static bool volatile	g_bStop = false;
+
+//-----------------------------------------------------------------------------
+// ʱ䣬΢
+//-----------------------------------------------------------------------------
+static unsigned long long BenchNow()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+// ʱʱЭ̽IOָ̻߳
+//-----------------------------------------------------------------------------
+class BenchTimer
+{
+public:
+	class XSleepAwaiter
+	{
+	public:
+		XSleepAwaiter(BenchTimer* pTimer, unsigned long long qwTime) : m_pTimer(pTimer), m_qwTime(qwTime) {}
+
+		bool await_ready() { return BenchNow() >= m_qwTime; }
+		void await_suspend(XCoroHandle h) { m_pTimer->Add(m_qwTime, h); }
+		void await_resume() {}
+
+	private:
+		BenchTimer*			m_pTimer;
+		unsigned long long	m_qwTime;
+	};
+
+	XSleepAwaiter SleepUntil(unsigned long long qwTime) { return XSleepAwaiter(this, qwTime); }
+
+	void Start(XIoPort* pPort)
+	{
+		m_pPort = pPort;
+		m_bStop = false;
+		m_Thread = std::thread(&BenchTimer::TimerThread, this);
+	}
+
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_bStop = true;
+		}
+		m_Cond.notify_one();
+		m_Thread.join();
+	}
+
+private:
+	typedef std::pair<unsigned long long, void*> TimerItem;
+
+	void Add(unsigned long long qwTime, XCoroHandle h)
+	{
+		bool bFirst;
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			bFirst = m_Queue.empty() || qwTime < m_Queue.top().first;
+			m_Queue.push(TimerItem(qwTime, h.address()));
+		}
+		if (bFirst)
+		{
+			m_Cond.notify_one();
+		}
+	}
+
+	void TimerThread()
+	{
+		XTRACE_THREAD_NAME("BenchTimer");
+
+		std::unique_lock<std::mutex> lock(m_Lock);
+		while (!m_bStop)
+		{
+			if (m_Queue.empty())
+			{
+				m_Cond.wait(lock);
+				continue;
+			}
+
+			unsigned long long qwNow = BenchNow();
+			if (m_Queue.top().first > qwNow)
+			{
+				m_Cond.wait_for(lock, std::chrono::microseconds(m_Queue.top().first - qwNow));
+				continue;
+			}
+
+			while (!m_Queue.empty() && m_Queue.top().first <= qwNow)
+			{
+				m_pPort->Post(XCoroHandle::from_address(m_Queue.top().second));
+				m_Queue.pop();
+			}
+		}
+	}
+
+	XIoPort*					m_pPort;
+	std::mutex					m_Lock;
+	std::condition_variable		m_Cond;
+	std::priority_queue<TimerItem, std::vector<TimerItem>, std::greater<TimerItem>>	m_Queue;
+	std::thread					m_Thread;
+	bool						m_bStop;
+};
+
+//-----------------------------------------------------------------------------
+// Zipfֲkey㷨ͬYCSBٴɢȵ㲻ڵkey
+//-----------------------------------------------------------------------------
+class BenchZipfian
+{
+public:
+	BenchZipfian(unsigned long long qwItems, double dTheta)
+		: m_qwItems(qwItems)
+		, m_dTheta(dTheta)
+		, m_dZetaN(0.0)
+		, m_dAlpha(0.0)
+		, m_dEta(0.0)
+	{
+		if (m_dTheta <= 0.0)
+		{
+			return;
+		}
+
+		for (unsigned long long n = 1; n <= m_qwItems; ++n)
+		{
+			m_dZetaN += 1.0 / pow((double)n, m_dTheta);
+		}
+		double dZeta2 = 1.0 + pow(0.5, m_dTheta);
+		m_dAlpha = 1.0 / (1.0 - m_dTheta);
+		m_dEta = (1.0 - pow(2.0 / m_qwItems, 1.0 - m_dTheta)) / (1.0 - dZeta2 / m_dZetaN);
+	}
+
+	//-----------------------------------------------------------------------------
+	// 1qwItems
+	//-----------------------------------------------------------------------------
+	template<typename Rng>
+	unsigned long long Next(Rng& rng) const
+	{
+		double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+		unsigned long long qwRank;
+		if (m_dTheta <= 0.0)
+		{
+			qwRank = (unsigned long long)(u * m_qwItems);
+		}
+		else
+		{
+			double uz = u * m_dZetaN;
+			if (uz < 1.0)
+			{
+				qwRank = 0;
+			}
+			else if (uz < 1.0 + pow(0.5, m_dTheta))
+			{
+				qwRank = 1;
+			}
+			else
+			{
+				qwRank = (unsigned long long)(m_qwItems * pow(m_dEta * u - m_dEta + 1.0, m_dAlpha));
+			}
+		}
+
+		if (qwRank >= m_qwItems)
+		{
+			qwRank = m_qwItems - 1;
+		}
+		return Scramble(qwRank) % m_qwItems + 1;
+	}
+
+private:
+	static unsigned long long Scramble(unsigned long long qw)
+	{
+		qw ^= qw >> 33;
+		qw *= 0xFF51AFD7ED558CCDULL;
+		qw ^= qw >> 33;
+		qw *= 0xC4CEB9FE1A85EC53ULL;
+		qw ^= qw >> 33;
+		return qw;
+	}
+
+	unsigned long long	m_qwItems;
+	double				m_dTheta;
+	double				m_dZetaN;
+	double				m_dAlpha;
+	double				m_dEta;
+};
+
+//-----------------------------------------------------------------------------
+// һͻˣƻʱ䷢󣬵Ȼظ¼ӳ
+//-----------------------------------------------------------------------------
+static XTask<void> BenchClient(XIoPort& port, BenchTimer& timer, const BenchZipfian& zipf, const tagBenchConfig& cfg,
+	SOCKET s, int nIndex, unsigned long long qwStart, unsigned long long qwMeasure, unsigned long long qwEnd)
+{
+	co_await port.Schedule();
+
+	std::mt19937_64 rng(cfg.dwSeed * 1000003ULL + nIndex);
+	std::string request;
+	std::string body;
+	tagDBMsgHead head;
+
+	// ÿͻ˵
+	double dInterval = 1e6 * cfg.nClients / cfg.nRate;
+	double dNext = qwStart + std::uniform_real_distribution<double>(0.0, dInterval)(rng);
+	while (!g_bStop && dNext < qwEnd)
+	{
+		unsigned long long qwPlanned = (unsigned long long)dNext;
+		dNext += dInterval;
+		co_await timer.SleepUntil(qwPlanned);
+
+		int nOp;
+		int nRoll = (int)(rng() % 100);
+		if (nRoll < cfg.nRead)
+		{
+			nOp = OP_GET;
+		}
+		else if (nRoll < cfg.nRead + cfg.nWrite)
+		{
+			nOp = OP_PUT;
+		}
+		else
+		{
+			nOp = OP_RANK_SET + (int)(rng() % 4);
+		}
+
+		ZeroMemory(&head, sizeof(head));
+		head.wType = g_wOpType[nOp];
+		head.qwKey = zipf.Next(rng);
+		switch (nOp)
+		{
+		case OP_PUT:
+			head.dwSize = cfg.dwMinSize + (DWORD)(rng() % (cfg.dwMaxSize - cfg.dwMinSize + 1));
+			break;
+		case OP_RANK_SET:
+			head.llParam = (long long)(rng() % 1000000);
+			break;
+		case OP_RANK_TOP:
+			head.llParam = 10;
+			break;
+		case OP_RANK_AROUND:
+			head.qwKey = 1 + rng() % 1000;
+			head.llParam = 5;
+			break;
+		}
+
+		request.assign((const char*)&head, sizeof(head));
+		request.resize(sizeof(head) + head.dwSize, (char)nIndex);
+		if (!co_await port.SendAll(s, request.data(), (DWORD)request.size())
+			|| !co_await port.RecvAll(s, &head, sizeof(head)))
+		{
+			::InterlockedIncrement((LPLONG)&g_lErrors);
+			break;
+		}
+
+		body.resize(head.dwSize);
+		if (head.dwSize > 0 && !co_await port.RecvAll(s, &body[0], head.dwSize))
+		{
+			::InterlockedIncrement((LPLONG)&g_lErrors);
+			break;
+		}
+
+		// ӼƻʱŶӵȴʱҲ
+		if (qwPlanned >= qwMeasure)
+		{
+			g_Histogram[nOp].Record(BenchNow() - qwPlanned);
+		}
+	}
+
+	port.Detach(s);
+	closesocket(s);
+	::InterlockedDecrement((LPLONG)&g_lClients);
+}
+
+//-----------------------------------------------------------------------------
+// ӷ
+//-----------------------------------------------------------------------------
+static SOCKET BenchConnect(const char* szHost, const char* szPort)
+{
+	addrinfo hints;
+	ZeroMemory(&hints, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* pResult = nullptr;
+	if (getaddrinfo(szHost, szPort, &hints, &pResult) != 0 || pResult == nullptr)
+	{
+		return INVALID_SOCKET;
+	}
+
+	SOCKET s = (SOCKET)socket(pResult->ai_family, pResult->ai_socktype, pResult->ai_protocol);
+	if (s != INVALID_SOCKET && connect(s, pResult->ai_addr, (int)pResult->ai_addrlen) != 0)
+	{
+		closesocket(s);
+		s = INVALID_SOCKET;
+	}
+	freeaddrinfo(pResult);
+
+	if (s != INVALID_SOCKET)
+	{
+		int nNoDelay = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&nNoDelay, sizeof(nNoDelay));
+	}
+	return s;
+}
+
+//-----------------------------------------------------------------------------
+// ÷
+//-----------------------------------------------------------------------------
+static void Usage()
+{
+	printf("usage: dbbench [options]\n"
+		"  -h host         dbserver address (127.0.0.1)\n"
+		"  -p port         dbserver port (9100)\n"
+		"  -c clients      connections (1000)\n"
+		"  -r rate         total requests per second (20000)\n"
+		"  -d seconds      measured duration (30)\n"
+		"  -w seconds      warmup, not measured (5)\n"
+		"  -t threads      io threads (4)\n"
+		"  -m r:w          read and write percent, rest is leaderboard (70:20)\n"
+		"  -k keys         key count (1000000)\n"
+		"  -z theta        zipf skew, 0 for uniform (0.99)\n"
+		"  -s min:max      record size in bytes (64:512)\n"
+		"  -S seed         random seed (1)\n"
+		"  -o prefix       write HDR percentile distribution to prefix.<op>.hdr\n");
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+static bool ParseArgs(int argc, char* argv[], tagBenchConfig& cfg)
+{
+	cfg.szHost = "127.0.0.1";
+	cfg.szPort = "9100";
+	cfg.nClients = 1000;
+	cfg.nRate = 20000;
+	cfg.nDuration = 30;
+	cfg.nWarmup = 5;
+	cfg.nThreads = 4;
+	cfg.nRead = 70;
+	cfg.nWrite = 20;
+	cfg.qwKeys = 1000000;
+	cfg.dTheta = 0.99;
+	cfg.dwMinSize = 64;
+	cfg.dwMaxSize = 512;
+	cfg.dwSeed = 1;
+	cfg.szHdrFile = nullptr;
+
+	for (int n = 1; n < argc; ++n)
+	{
+		if (argv[n][0] != '-' || argv[n][1] == 0 || argv[n][2] != 0 || n + 1 >= argc)
+		{
+			return false;
+		}
+
+		const char* szValue = argv[++n];
+		switch (argv[n - 1][1])
+		{
+		case 'h': cfg.szHost = szValue; break;
+		case 'p': cfg.szPort = szValue; break;
+		case 'c': cfg.nClients = atoi(szValue); break;
+		case 'r': cfg.nRate = atoi(szValue); break;
+		case 'd': cfg.nDuration = atoi(szValue); break;
+		case 'w': cfg.nWarmup = atoi(szValue); break;
+		case 't': cfg.nThreads = atoi(szValue); break;
+		case 'm':
+			if (sscanf(szValue, "%d:%d", &cfg.nRead, &cfg.nWrite) != 2)
+			{
+				return false;
+			}
+			break;
+		case 'k': cfg.qwKeys = strtoull(szValue, NULL, 10); break;
+		case 'z': cfg.dTheta = atof(szValue); break;
+		case 's':
+			if (sscanf(szValue, "%u:%u", &cfg.dwMinSize, &cfg.dwMaxSize) != 2)
+			{
+				return false;
+			}
+			break;
+		case 'S': cfg.dwSeed = (unsigned int)strtoul(szValue, NULL, 10); break;
+		case 'o': cfg.szHdrFile = szValue; break;
+		default:
+			return false;
+		}
+	}
+
+	return cfg.nClients > 0 && cfg.nRate > 0 && cfg.nDuration > 0 && cfg.nWarmup >= 0 && cfg.nThreads > 0
+		&& cfg.nRead >= 0 && cfg.nWrite >= 0 && cfg.nRead + cfg.nWrite <= 100 && cfg.qwKeys > 0
+		&& cfg.dTheta < 1.0 && cfg.dwMinSize <= cfg.dwMaxSize && cfg.dwMaxSize <= 1024 * 1024;
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+static void Report(const tagBenchConfig& cfg)
+{
+	XHistogram* pTotal = new XHistogram;
+
+	printf("\n%-12s %10s %10s %10s %10s %10s %10s %10s %10s\n", "op", "count", "req/s", "p50(ms)", "p90", "p99", "p99.9", "p99.99", "max");
+	for (int n = 0; n <= OP_NUM; ++n)
+	{
+		const XHistogram& hist = n < OP_NUM ? g_Histogram[n] : *pTotal;
+		if (n < OP_NUM)
+		{
+			pTotal->Add(hist);
+		}
+
+		if (hist.GetTotalCount() == 0)
+		{
+			continue;
+		}
+
+		printf("%-12s %10llu %10.0f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+			n < OP_NUM ? g_szOpName[n] : "all",
+			hist.GetTotalCount(),
+			(double)hist.GetTotalCount() / cfg.nDuration,
+			hist.GetValueAtPercentile(50.0) / 1000.0,
+			hist.GetValueAtPercentile(90.0) / 1000.0,
+			hist.GetValueAtPercentile(99.0) / 1000.0,
+			hist.GetValueAtPercentile(99.9) / 1000.0,
+			hist.GetValueAtPercentile(99.99) / 1000.0,
+			hist.GetMax() / 1000.0);
+
+		if (cfg.szHdrFile)
+		{
+			char szFile[512];
+			snprintf(szFile, sizeof(szFile), "%s.%s.hdr", cfg.szHdrFile, n < OP_NUM ? g_szOpName[n] : "all");
+			FILE* fp = fopen(szFile, "w");
+			if (fp)
+			{
+				hist.OutputPercentiles(fp, 1000.0);
+				fclose(fp);
+			}
+		}
+	}
+
+	printf("errors %ld, unfinished %ld\n", (long)g_lErrors, (long)g_lClients);
+	delete pTotal;
+}
+
+#endif // XCORO_SUPPORTED
+
+int main(int argc, char* argv[])
+{
+#if XCORO_SUPPORTED
+	tagBenchConfig cfg;
+	if (!ParseArgs(argc, argv, cfg))
+	{
+		Usage();
+		return 1;
+	}
+
+	g_pMemCache = new XMemCache<XAtomMutex>(256 * 1024 * 1024);
+
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		return 1;
+	}
+#endif
+
+	XIoPort port;
+	if (!port.Create())
+	{
+		printf("create io port failed\n");
+		return 1;
+	}
+
+	// Ƚӣʱ
+	std::vector<SOCKET> sockets;
+	for (int n = 0; n < cfg.nClients; ++n)
+	{
+		SOCKET s = BenchConnect(cfg.szHost, cfg.szPort);
+		if (s == INVALID_SOCKET || !port.Attach(s))
+		{
+			printf("connect %s:%s failed after %d clients\n", cfg.szHost, cfg.szPort, n);
+			return 1;
+		}
+		sockets.push_back(s);
+	}
+
+	printf("building zipf table for %llu keys...\n", cfg.qwKeys);
+	BenchZipfian zipf(cfg.qwKeys, cfg.dTheta);
+
+	BenchTimer timer;
+	timer.Start(&port);
+
+	std::vector<std::thread> threads;
+	for (int n = 0; n < cfg.nThreads; ++n)
+	{
+		threads.emplace_back([&port]()
+		{
+			XTRACE_THREAD_NAME("BenchIo");
+			port.Run();
+		});
+	}
+
+	printf("%d clients, %d req/s, read %d%% write %d%% rank %d%%, warmup %ds, measure %ds\n",
+		cfg.nClients, cfg.nRate, cfg.nRead, cfg.nWrite, 100 - cfg.nRead - cfg.nWrite, cfg.nWarmup, cfg.nDuration);
+
+	unsigned long long qwStart = BenchNow();
+	unsigned long long qwMeasure = qwStart + cfg.nWarmup * 1000000ULL;
+	unsigned long long qwEnd = qwMeasure + cfg.nDuration * 1000000ULL;
+	g_lClients = cfg.nClients;
+	for (int n = 0; n < cfg.nClients; ++n)
+	{
+		BenchClient(port, timer, zipf, cfg, sockets[n], n, qwStart, qwMeasure, qwEnd).Detach();
+	}
+
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::microseconds(qwEnd)));
+
+	// ڵȻظĿͻٵһ룬Ȳδ
+	unsigned long long qwDeadline = qwEnd + 1000000ULL;
+	while (g_lClients > 0 && BenchNow() < qwDeadline)
+	{
+		Sleep(10);
+	}
+	Report(cfg);
+
+	// ʣµǿƶϿ˳
+	g_bStop = true;
+	for (size_t n = 0; n < sockets.size(); ++n)
+	{
+#ifdef _WIN32
+		::CancelIoEx((HANDLE)sockets[n], NULL);
+#else
+		shutdown((int)sockets[n], SHUT_RDWR);
+#endif
+	}
+	while (g_lClients > 0)
+	{
+		Sleep(10);
+	}
+
+	port.Stop();
+	for (auto& th : threads)
+	{
+		th.join();
+	}
+	timer.Stop();
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+#else
+	printf("dbbench needs C++20 coroutines (/std:c++latest)\n");
+#endif
+
+	return 0;
+}
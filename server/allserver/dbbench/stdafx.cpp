@@ -0,0 +1,8 @@
+// stdafx.cpp : ֻ׼ļԴļ
+// dbbench.pch ΪԤͷ
+// stdafx.obj ԤϢ
+
+#include "stdafx.h"
+
+// TODO:  STDAFX.H κĸͷļ
+//ڴļ
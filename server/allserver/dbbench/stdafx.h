@@ -0,0 +1,17 @@
+// stdafx.h : ׼ϵͳļİļ
+// Ǿʹõĵ
+// ضĿİļ
+//
+
+#pragma once
+
+#ifdef _WIN32
+#	include "targetver.h"
+#	include <tchar.h>
+#endif
+
+#include <stdio.h>
+
+
+
+// TODO:  ڴ˴óҪͷļ
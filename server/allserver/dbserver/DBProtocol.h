@@ -0,0 +1,63 @@
+#pragma once
+
+#ifndef __DBPROTOCOL_H__
+#define __DBPROTOCOL_H__
+
+#include "XDeclare.h"
+#include "XRecord.h"
+
+//-----------------------------------------------------------------------------
+// Ϣ
+//-----------------------------------------------------------------------------
+enum
+{
+	DB_MSG_GET = 1,		// ¼qwKey
+	DB_MSG_PUT,			// д¼qwKeyϢΪ
+	DB_MSG_RANK_SET,	// ÷qwKeyΪIDllParamΪ̺ظ
+	DB_MSG_RANK_GET,	// ΣqwKeyΪIDظllParamΪ
+	DB_MSG_RANK_TOP,	// ǰNllParamΪNظϢΪtagRankItem
+	DB_MSG_RANK_AROUND,	// θqwKeyΪΣllParamΪǰ
+	DB_MSG_NAME_BIND,	// ֣˺ȣϢΪ֣qwKeyΪӦļ¼key
+	DB_MSG_NAME_GET,	// ֲ¼keyϢΪ֣ظqwKey
+	DB_MSG_TRACE,		// ãllParam0ʼ¼٣Ϊ0ʱֹͣдļ.trace.jsonظllParamΪ¼
+	DB_MSG_PATCH,		// ֶ޸ļ¼qwKeyllParamΪ¼ʽţDBService::RegisterSchemaϢΪXRecordDelta
+};
+
+//-----------------------------------------------------------------------------
+// ְҲɼ¼keyΪֹϣλͨ¼Ҫλ
+// ¼ΪXRecordʽDB_MSG_GETֱXRecordView
+//-----------------------------------------------------------------------------
+const unsigned long long DB_NAME_KEY_FLAG = 0x8000000000000000ULL;
+
+enum
+{
+	DB_MAX_NAME_SIZE = 63,
+};
+
+enum { ENF_Key, ENF_Name };
+typedef XRecordSchema<
+	XFixed<unsigned long long>,		// ENF_Key
+	XBytes<DB_MAX_NAME_SIZE + 1>	// ENF_Name
+> tagDBNameSchema;
+
+//-----------------------------------------------------------------------------
+// Ϣͷͻظֽͬ
+//-----------------------------------------------------------------------------
+#pragma pack(push, 1)
+struct tagDBMsgHead
+{
+	DWORD				dwSize;		// Ϣ峤ȣϢͷ
+	WORD				wType;
+	WORD				wResult;	// ظʱ0Ϊɹ
+	unsigned long long	qwKey;
+	long long			llParam;
+};
+#pragma pack(pop)
+
+//-----------------------------------------------------------------------------
+// ͬҲ߹ڴͨXShmChannelϢʽͬ
+// ϢͷϢͬһXShmChannel::MAX_MSG_SIZE
+// ظ޻ͨʱûôĿпʱwResultΪ0xFFFEûϢ壬ҪTCPԺ
+//-----------------------------------------------------------------------------
+
+#endif // !__DBPROTOCOL_H__
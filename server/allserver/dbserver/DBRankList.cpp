@@ -0,0 +1,486 @@
+#include "stdafx.h"
+#include "DBRankList.h"
+
+extern XMemCache<XAtomMutex>*	g_pMemCache;
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+DBRankList::DBRankList()
+	: m_lSeq(0)
+	, m_nLevel(1)
+	, m_nLength(0)
+	, m_dwRandom(0x2545F491)
+{
+	// ʧʱа񲻿ãUpdatefalseȡؿ
+	m_pHead = CreateNode(MAX_LEVEL, 0, 0);
+
+	m_pBucket = (tagBucket*)MCALLOC(sizeof(tagBucket) + sizeof(tagNode*) * 63);
+	if (m_pBucket)
+	{
+		m_pBucket->dwMask = 63;
+		ZeroMemory((void*)m_pBucket->pHead, sizeof(tagNode*) * 64);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+DBRankList::~DBRankList()
+{
+	if (m_pHead)
+	{
+		tagNode* pNode = m_pHead->Level[0].pForward;
+		while (pNode)
+		{
+			tagNode* pNext = pNode->Level[0].pForward;
+			MCFREE(pNode);
+			pNode = pNext;
+		}
+		MCFREE(m_pHead);
+	}
+
+	if (m_pBucket)
+	{
+		MCFREE(m_pBucket);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ·
+//-----------------------------------------------------------------------------
+bool DBRankList::Update(unsigned long long qwID, long long llScore)
+{
+	if (!IsReady())
+	{
+		return false;
+	}
+
+	m_Lock.Lock();
+
+	tagNode* pOld = FindNode(qwID);
+	if (pOld && pOld->llScore == llScore)
+	{
+		m_Lock.Unlock();
+		return true;
+	}
+
+	// ߿ܻͣھɽڵϣԭ޸ģһ½ڵ
+	tagNode* pNode = CreateNode(RandomLevel(), qwID, llScore);
+	if (!pNode)
+	{
+		m_Lock.Unlock();
+		return false;	// ɷ
+	}
+
+	BeginWrite();
+	if (pOld)
+	{
+		Unlink(pOld);
+		HashRemove(pOld);
+		XEpoch::Retire(pOld);
+	}
+	Insert(pNode);
+	HashInsert(pNode);
+
+	EndWrite();
+	m_Lock.Unlock();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// ɾ
+//-----------------------------------------------------------------------------
+bool DBRankList::Remove(unsigned long long qwID)
+{
+	if (!IsReady())
+	{
+		return false;
+	}
+
+	m_Lock.Lock();
+
+	tagNode* pNode = FindNode(qwID);
+	if (!pNode)
+	{
+		m_Lock.Unlock();
+		return false;
+	}
+
+	BeginWrite();
+	Unlink(pNode);
+	HashRemove(pNode);
+	XEpoch::Retire(pNode);
+	EndWrite();
+
+	m_Lock.Unlock();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+int DBRankList::GetRank(unsigned long long qwID)
+{
+	if (!IsReady())
+	{
+		return 0;
+	}
+
+	int nRank = 0;
+	Read([this, qwID, &nRank]()
+	{
+		nRank = 0;
+		tagNode* pNode = FindNode(qwID);
+		if (!pNode)
+		{
+			return;
+		}
+
+		// ;ۼӿ
+		long long llScore = pNode->llScore;
+		int nTraversed = 0;
+		tagNode* x = m_pHead;
+		for (int i = m_nLevel - 1; i >= 0; --i)
+		{
+			tagNode* pNext;
+			while ((pNext = x->Level[i].pForward) != nullptr
+				&& (Before(pNext, llScore, qwID) || pNext->qwID == qwID))
+			{
+				nTraversed += x->Level[i].nSpan;
+				x = pNext;
+			}
+
+			if (x == pNode)
+			{
+				nRank = nTraversed;
+				return;
+			}
+		}
+	});
+	return nRank;
+}
+
+//-----------------------------------------------------------------------------
+// ȡ
+//-----------------------------------------------------------------------------
+bool DBRankList::GetScore(unsigned long long qwID, long long& llScore)
+{
+	if (!IsReady())
+	{
+		return false;
+	}
+
+	bool bFound = false;
+	Read([this, qwID, &llScore, &bFound]()
+	{
+		tagNode* pNode = FindNode(qwID);
+		bFound = (pNode != nullptr);
+		if (pNode)
+		{
+			llScore = pNode->llScore;
+		}
+	});
+	return bFound;
+}
+
+//-----------------------------------------------------------------------------
+// ȡһ
+//-----------------------------------------------------------------------------
+int DBRankList::GetRange(int nStart, int nCount, tagRankItem* pItems)
+{
+	if (nStart < 1 || nCount <= 0 || pItems == nullptr || !IsReady())
+	{
+		return 0;
+	}
+
+	int nGot = 0;
+	Read([this, nStart, nCount, pItems, &nGot]()
+	{
+		nGot = 0;
+		tagNode* pNode = GetByRank(nStart);
+		while (pNode && nGot < nCount)
+		{
+			pItems[nGot].qwID = pNode->qwID;
+			pItems[nGot].llScore = pNode->llScore;
+			pItems[nGot].nRank = nStart + nGot;
+			++nGot;
+			pNode = pNode->Level[0].pForward;
+		}
+	});
+	return nGot;
+}
+
+//-----------------------------------------------------------------------------
+// θ
+//-----------------------------------------------------------------------------
+int DBRankList::GetAround(int nRank, int nRadius, tagRankItem* pItems)
+{
+	if (nRank < 1 || nRadius < 0)
+	{
+		return 0;
+	}
+
+	// ǰҲȫխӲ
+	int nLength = m_nLength;
+	if (nRadius > nLength)
+	{
+		nRadius = nLength;
+	}
+
+	int nStart = nRank > nRadius ? nRank - nRadius : 1;
+	long long llCount = (long long)nRank + nRadius - nStart + 1;
+	return GetRange(nStart, (int)fxmin(llCount, (long long)nRadius * 2 + 1), pItems);
+}
+
+//-----------------------------------------------------------------------------
+// ʼдʱ߶İ汾
+//-----------------------------------------------------------------------------
+void DBRankList::BeginWrite()
+{
+	::InterlockedIncrement((LPLONG)&m_lSeq);
+}
+
+//-----------------------------------------------------------------------------
+// д
+//-----------------------------------------------------------------------------
+void DBRankList::EndWrite()
+{
+	::InterlockedIncrement((LPLONG)&m_lSeq);
+}
+
+//-----------------------------------------------------------------------------
+// ڵ
+//-----------------------------------------------------------------------------
+DBRankList::tagNode* DBRankList::CreateNode(int nLevel, unsigned long long qwID, long long llScore)
+{
+	tagNode* pNode = (tagNode*)MCALLOC(sizeof(tagNode) + sizeof(tagLevel) * (nLevel - 1));
+	if (!pNode)
+	{
+		return nullptr;
+	}
+
+	pNode->qwID = qwID;
+	pNode->llScore = llScore;
+	pNode->pHashNext = nullptr;
+	pNode->nLevel = nLevel;
+	for (int i = 0; i < nLevel; ++i)
+	{
+		pNode->Level[i].pForward = nullptr;
+		pNode->Level[i].nSpan = 0;
+	}
+	return pNode;
+}
+
+//-----------------------------------------------------------------------------
+// ID
+//-----------------------------------------------------------------------------
+DBRankList::tagNode* DBRankList::FindNode(unsigned long long qwID)
+{
+	tagBucket* pBucket = m_pBucket;
+	tagNode* pNode = pBucket->pHead[Hash(qwID) & pBucket->dwMask];
+	while (pNode && pNode->qwID != qwID)
+	{
+		pNode = pNode->pHashNext;
+	}
+	return pNode;
+}
+
+//-----------------------------------------------------------------------------
+// β
+//-----------------------------------------------------------------------------
+DBRankList::tagNode* DBRankList::GetByRank(int nRank)
+{
+	int nTraversed = 0;
+	tagNode* x = m_pHead;
+	for (int i = m_nLevel - 1; i >= 0; --i)
+	{
+		tagNode* pNext;
+		while ((pNext = x->Level[i].pForward) != nullptr && nTraversed + x->Level[i].nSpan <= nRank)
+		{
+			nTraversed += x->Level[i].nSpan;
+			x = pNext;
+		}
+
+		if (nTraversed == nRank)
+		{
+			return x;
+		}
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// 
+// ½ڵȰԼĺ̺Ϳãٹҵǰϣκʱ򿴵
+//-----------------------------------------------------------------------------
+void DBRankList::Insert(tagNode* pNode)
+{
+	tagNode* update[MAX_LEVEL];
+	int rank[MAX_LEVEL];
+
+	tagNode* x = m_pHead;
+	for (int i = m_nLevel - 1; i >= 0; --i)
+	{
+		rank[i] = (i == m_nLevel - 1) ? 0 : rank[i + 1];
+		tagNode* pNext;
+		while ((pNext = x->Level[i].pForward) != nullptr && Before(pNext, pNode->llScore, pNode->qwID))
+		{
+			rank[i] += x->Level[i].nSpan;
+			x = pNext;
+		}
+		update[i] = x;
+	}
+
+	int nLevel = pNode->nLevel;
+	if (nLevel > m_nLevel)
+	{
+		for (int i = m_nLevel; i < nLevel; ++i)
+		{
+			rank[i] = 0;
+			update[i] = m_pHead;
+			m_pHead->Level[i].nSpan = m_nLength;
+		}
+		m_nLevel = nLevel;
+	}
+
+	for (int i = 0; i < nLevel; ++i)
+	{
+		pNode->Level[i].pForward = update[i]->Level[i].pForward;
+		pNode->Level[i].nSpan = update[i]->Level[i].nSpan - (rank[0] - rank[i]);
+		update[i]->Level[i].pForward = pNode;
+		update[i]->Level[i].nSpan = rank[0] - rank[i] + 1;
+	}
+
+	for (int i = nLevel; i < m_nLevel; ++i)
+	{
+		::InterlockedIncrement((LPLONG)&update[i]->Level[i].nSpan);
+	}
+
+	::InterlockedIncrement((LPLONG)&m_nLength);
+}
+
+//-----------------------------------------------------------------------------
+// ժڵԼĺ̲ͣĶ߻ȥ
+//-----------------------------------------------------------------------------
+void DBRankList::Unlink(tagNode* pNode)
+{
+	tagNode* update[MAX_LEVEL];
+
+	tagNode* x = m_pHead;
+	for (int i = m_nLevel - 1; i >= 0; --i)
+	{
+		tagNode* pNext;
+		while ((pNext = x->Level[i].pForward) != nullptr && Before(pNext, pNode->llScore, pNode->qwID))
+		{
+			x = pNext;
+		}
+		update[i] = x;
+	}
+
+	for (int i = 0; i < m_nLevel; ++i)
+	{
+		if (update[i]->Level[i].pForward == pNode)
+		{
+			::InterlockedExchangeAdd((LPLONG)&update[i]->Level[i].nSpan, pNode->Level[i].nSpan - 1);
+			update[i]->Level[i].pForward = pNode->Level[i].pForward;
+		}
+		else
+		{
+			::InterlockedDecrement((LPLONG)&update[i]->Level[i].nSpan);
+		}
+	}
+
+	while (m_nLevel > 1 && m_pHead->Level[m_nLevel - 1].pForward == nullptr)
+	{
+		::InterlockedDecrement((LPLONG)&m_nLevel);
+	}
+
+	::InterlockedDecrement((LPLONG)&m_nLength);
+}
+
+//-----------------------------------------------------------------------------
+// ϣ
+//-----------------------------------------------------------------------------
+void DBRankList::HashInsert(tagNode* pNode)
+{
+	if ((unsigned int)m_nLength > m_pBucket->dwMask)
+	{
+		HashGrow();
+	}
+
+	unsigned int dwIndex = Hash(pNode->qwID) & m_pBucket->dwMask;
+	pNode->pHashNext = m_pBucket->pHead[dwIndex];
+	m_pBucket->pHead[dwIndex] = pNode;
+}
+
+//-----------------------------------------------------------------------------
+// ӹϣժڵpHashNext
+//-----------------------------------------------------------------------------
+void DBRankList::HashRemove(tagNode* pNode)
+{
+	tagNode* volatile* ppNode = &m_pBucket->pHead[Hash(pNode->qwID) & m_pBucket->dwMask];
+	while (*ppNode && *ppNode != pNode)
+	{
+		ppNode = &(*ppNode)->pHashNext;
+	}
+
+	if (*ppNode)
+	{
+		*ppNode = pNode->pHashNext;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ϣݣ±ú滻ɱӳͷ
+// Ųж߿Ҳڵ㣬ϲл汾У
+//-----------------------------------------------------------------------------
+void DBRankList::HashGrow()
+{
+	tagBucket* pOld = m_pBucket;
+	unsigned int dwMask = pOld->dwMask * 2 + 1;
+	tagBucket* pNew = (tagBucket*)MCALLOC(sizeof(tagBucket) + sizeof(tagNode*) * dwMask);
+	if (!pNew)
+	{
+		return;	// ʧֻ䳤
+	}
+
+	pNew->dwMask = dwMask;
+	ZeroMemory((void*)pNew->pHead, sizeof(tagNode*) * (dwMask + 1));
+
+	for (unsigned int n = 0; n <= pOld->dwMask; ++n)
+	{
+		tagNode* pNode = pOld->pHead[n];
+		while (pNode)
+		{
+			tagNode* pNext = pNode->pHashNext;
+			unsigned int dwIndex = Hash(pNode->qwID) & dwMask;
+			pNode->pHashNext = pNew->pHead[dwIndex];
+			pNew->pHead[dwIndex] = pNode;
+			pNode = pNext;
+		}
+	}
+
+	m_pBucket = pNew;
+	XEpoch::Retire(pOld);
+}
+
+//-----------------------------------------------------------------------------
+// ÿ1/4
+//-----------------------------------------------------------------------------
+int DBRankList::RandomLevel()
+{
+	int nLevel = 1;
+	while (nLevel < MAX_LEVEL)
+	{
+		m_dwRandom ^= m_dwRandom << 13;
+		m_dwRandom ^= m_dwRandom >> 17;
+		m_dwRandom ^= m_dwRandom << 5;
+		if ((m_dwRandom & 3) != 0)
+		{
+			break;
+		}
+		++nLevel;
+	}
+	return nLevel;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#ifndef __DBRANKLIST_H__
+#define __DBRANKLIST_H__
+
+#include "XEpoch.h"
+
+//-----------------------------------------------------------------------------
+// аĿ
+//-----------------------------------------------------------------------------
+struct tagRankItem
+{
+	unsigned long long	qwID;		// ID
+	long long			llScore;	// 
+	int					nRank;		// Σ1ʼ
+};
+
+//-----------------------------------------------------------------------------
+// аȵߵǰͬIDСǰ
+// д봮мȡð汾У飬ͻκ˻ؼ
+// ɾĽڵ㽻XEpochȶ߶뿪ٹ黹ڴ
+//-----------------------------------------------------------------------------
+class DBRankList
+{
+public:
+	enum
+	{
+		MAX_LEVEL = 32,
+	};
+
+	//-----------------------------------------------------------------------------
+	// ·ڴ治ʱfalseԭķ
+	//-----------------------------------------------------------------------------
+	bool Update(unsigned long long qwID, long long llScore);
+
+	//-----------------------------------------------------------------------------
+	// ɾڷfalse
+	//-----------------------------------------------------------------------------
+	bool Remove(unsigned long long qwID);
+
+	//-----------------------------------------------------------------------------
+	// Σ1ʼڰϷ0
+	//-----------------------------------------------------------------------------
+	int GetRank(unsigned long long qwID);
+
+	//-----------------------------------------------------------------------------
+	// ȡڰϷfalse
+	//-----------------------------------------------------------------------------
+	bool GetScore(unsigned long long qwID, long long& llScore);
+
+	//-----------------------------------------------------------------------------
+	// nStartʼȡnCountʵʸ
+	//-----------------------------------------------------------------------------
+	int GetRange(int nStart, int nCount, tagRankItem* pItems);
+
+	//-----------------------------------------------------------------------------
+	// ǰN
+	//-----------------------------------------------------------------------------
+	int GetTop(int nCount, tagRankItem* pItems) { return GetRange(1, nCount, pItems); }
+
+	//-----------------------------------------------------------------------------
+	// nRankǰnRadiuspItemsҪܷnRadius * 2 + 1
+	//-----------------------------------------------------------------------------
+	int GetAround(int nRank, int nRadius, tagRankItem* pItems);
+
+	//-----------------------------------------------------------------------------
+	int GetCount() { return m_nLength; }
+
+	//-----------------------------------------------------------------------------
+	DBRankList();
+	~DBRankList();
+
+private:
+	struct tagNode;
+
+	struct tagLevel
+	{
+		tagNode* volatile	pForward;	// һڵ
+		int volatile		nSpan;		// һڵ
+	};
+
+	struct tagNode
+	{
+		unsigned long long	qwID;
+		long long			llScore;
+		tagNode* volatile	pHashNext;	// IDϣ
+		int					nLevel;
+		tagLevel			Level[1];	// ʵnLevel
+	};
+
+	// IDϣ滻õĸĸ
+	struct tagBucket
+	{
+		unsigned int		dwMask;
+		tagNode* volatile	pHead[1];
+	};
+
+	//-----------------------------------------------------------------------------
+	// aǷ(llScore, qwID)ǰ
+	//-----------------------------------------------------------------------------
+	static bool Before(const tagNode* a, long long llScore, unsigned long long qwID)
+	{
+		return a->llScore > llScore || (a->llScore == llScore && a->qwID < qwID);
+	}
+
+	//-----------------------------------------------------------------------------
+	// ʱķǷɹ
+	//-----------------------------------------------------------------------------
+	bool IsReady() const
+	{
+		return m_pHead != nullptr && m_pBucket != nullptr;
+	}
+
+	static unsigned int Hash(unsigned long long qwID)
+	{
+		return (unsigned int)((qwID * 0x9E3779B97F4A7C15ULL) >> 32);
+	}
+
+	//-----------------------------------------------------------------------------
+	// һµͼִж
+	//-----------------------------------------------------------------------------
+	template<typename Func>
+	void Read(Func fn);
+
+	//-----------------------------------------------------------------------------
+	// дʼͽ汾Ϊʱʾд
+	//-----------------------------------------------------------------------------
+	void BeginWrite();
+	void EndWrite();
+
+	tagNode* CreateNode(int nLevel, unsigned long long qwID, long long llScore);
+	tagNode* FindNode(unsigned long long qwID);
+	tagNode* GetByRank(int nRank);
+	void Insert(tagNode* pNode);
+	void Unlink(tagNode* pNode);
+	void HashInsert(tagNode* pNode);
+	void HashRemove(tagNode* pNode);
+	void HashGrow();
+	int RandomLevel();
+
+	XMutex						m_Lock;			// д
+	LONG volatile				m_lSeq;			// 汾
+
+	tagNode*					m_pHead;		// ͷڵ㣬MAX_LEVEL
+	int volatile				m_nLevel;		// ǰ߲
+	int volatile				m_nLength;		// ڵ
+	tagBucket* volatile			m_pBucket;
+	unsigned int				m_dwRandom;		// 
+};
+
+//-----------------------------------------------------------------------------
+// ʱ򲻼ǰ汾һ²ɹ
+//-----------------------------------------------------------------------------
+template<typename Func>
+void DBRankList::Read(Func fn)
+{
+	XEpochGuard guard;	// ڼ俴Ľڵ㲻ᱻͷ
+
+	bool bDone = false;
+	for (int n = 0; n < 8 && !bDone; ++n)
+	{
+		LONG lSeq = ::InterlockedCompareExchange((LPLONG)&m_lSeq, 0, 0);
+		if (lSeq & 1)
+		{
+			Sleep(0);	// д
+			continue;
+		}
+
+		fn();
+		bDone = (::InterlockedCompareExchange((LPLONG)&m_lSeq, 0, 0) == lSeq);
+	}
+
+	// д̫Ƶһ
+	if (!bDone)
+	{
+		m_Lock.Lock();
+		fn();
+		m_Lock.Unlock();
+	}
+}
+
+#endif // !__DBRANKLIST_H__
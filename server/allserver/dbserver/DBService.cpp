@@ -0,0 +1,621 @@
+#include "stdafx.h"
+#include "DBService.h"
+
+#if XCORO_SUPPORTED
+
+#ifdef _WIN32
+#	define SOCKET_SHUTDOWN(s)	::CancelIoEx((HANDLE)(s), NULL)
+#else
+#	include <netinet/in.h>
+#	include <netinet/tcp.h>
+#	define INVALID_SOCKET		((SOCKET)(~0))
+#	define SOCKET_SHUTDOWN(s)	shutdown((int)(s), SHUT_RDWR)
+#	define closesocket(s)		close((int)(s))
+#endif
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+DBService::DBService()
+	: m_sListen(INVALID_SOCKET)
+	, m_bStop(false)
+	, m_lShmPending(0)
+{
+	ZeroMemory(m_Schemas, sizeof(m_Schemas));
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+DBService::~DBService()
+{
+	Stop();
+}
+
+//-----------------------------------------------------------------------------
+// ǼǼ¼ʽ
+//-----------------------------------------------------------------------------
+bool DBService::RegisterSchema(unsigned int dwSchema, DBStore::DBPatchFunc pfnPatch, unsigned int dwMaxSize)
+{
+	if (dwSchema >= MAX_SCHEMA || m_Schemas[dwSchema].pfnPatch)
+	{
+		return false;
+	}
+
+	m_Schemas[dwSchema].pfnPatch = pfnPatch;
+	m_Schemas[dwSchema].dwMaxSize = dwMaxSize;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+bool DBService::Start(unsigned short wPort, const char* szDataFile, int nThreads)
+{
+	if (!m_Port.Create() || !m_Store.Open(&m_Port, szDataFile))
+	{
+		return false;
+	}
+
+	// ֻдûͶ߳
+	m_strTraceFile = szDataFile;
+	m_strTraceFile += ".trace.json";
+
+	std::string strRankFile = szDataFile;
+	strRankFile += ".rank";
+	if (!m_RankStore.Open(&m_Port, strRankFile.c_str(), 0, 1) || !LoadRank())
+	{
+		printf("DBService: load rank from %s failed\n", strRankFile.c_str());
+		return false;
+	}
+
+	m_sListen = (SOCKET)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (m_sListen == INVALID_SOCKET)
+	{
+		return false;
+	}
+
+	int nReuse = 1;
+	setsockopt(m_sListen, SOL_SOCKET, SO_REUSEADDR, (const char*)&nReuse, sizeof(nReuse));
+
+	sockaddr_in addr;
+	ZeroMemory(&addr, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(wPort);
+	if (bind(m_sListen, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(m_sListen, SOMAXCONN) != 0)
+	{
+		printf("DBService: listen on %u failed\n", wPort);
+		closesocket(m_sListen);
+		m_sListen = INVALID_SOCKET;
+		return false;
+	}
+
+	m_bStop = false;
+	for (int n = 0; n < nThreads; ++n)
+	{
+		m_IoThreads.emplace_back([this]()
+		{
+			XTRACE_THREAD_NAME("DBServiceIo");
+			m_Port.Run();
+		});
+	}
+	m_AcceptThread = std::thread(&DBService::AcceptThread, this);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// ڴͨ
+//-----------------------------------------------------------------------------
+bool DBService::StartShm(const char* szName)
+{
+	if (m_sListen == INVALID_SOCKET || m_Shm.IsOpen() || !m_Shm.Create(szName))
+	{
+		return false;
+	}
+
+	m_ShmThread = std::thread(&DBService::ShmThread, this);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// ֹͣ
+//-----------------------------------------------------------------------------
+void DBService::Stop()
+{
+	if (m_sListen == INVALID_SOCKET)
+	{
+		return;
+	}
+
+	// ֹͣ
+	m_bStop = true;
+	SOCKET_SHUTDOWN(m_sListen);
+	closesocket(m_sListen);
+	m_sListen = INVALID_SOCKET;
+	if (m_AcceptThread.joinable())
+	{
+		m_AcceptThread.join();
+	}
+
+	// жϹշЭȫ
+	m_SessionLock.Lock();
+	for (size_t n = 0; n < m_Sessions.size(); ++n)
+	{
+		SOCKET_SHUTDOWN(m_Sessions[n]);
+	}
+	m_SessionLock.Unlock();
+
+	for (;;)
+	{
+		m_SessionLock.Lock();
+		bool bEmpty = m_Sessions.empty();
+		m_SessionLock.Unlock();
+		if (bEmpty)
+		{
+			break;
+		}
+		Sleep(1);
+	}
+
+	// ڴͨ󣬵ȴеĻظ
+	if (m_ShmThread.joinable())
+	{
+		m_Shm.Interrupt();
+		m_ShmThread.join();
+	}
+	while (m_lShmPending > 0)
+	{
+		Sleep(1);
+	}
+	m_Shm.Close();
+
+	m_Port.Stop();
+	for (auto& th : m_IoThreads)
+	{
+		th.join();
+	}
+	m_IoThreads.clear();
+
+	m_Store.Close();
+	m_RankStore.Close();
+}
+
+//-----------------------------------------------------------------------------
+// ¼٣ڵõ߳ͬдļ
+//-----------------------------------------------------------------------------
+int DBService::DumpTrace()
+{
+	XTrace::SetEnable(false);
+	int nCount = XTrace::Dump(m_strTraceFile.c_str());
+	if (nCount < 0)
+	{
+		printf("DBService: write trace %s failed\n", m_strTraceFile.c_str());
+	}
+	else
+	{
+		printf("DBService: wrote %d trace events to %s\n", nCount, m_strTraceFile.c_str());
+	}
+	return nCount;
+}
+
+//-----------------------------------------------------------------------------
+// ӣÿһЭ
+//-----------------------------------------------------------------------------
+void DBService::AcceptThread()
+{
+	XTRACE_THREAD_NAME("DBServiceAccept");
+
+	while (!m_bStop)
+	{
+		SOCKET s = (SOCKET)accept(m_sListen, NULL, NULL);
+		if (s == INVALID_SOCKET)
+		{
+			continue;
+		}
+
+		if (m_bStop || !m_Port.Attach(s))
+		{
+			closesocket(s);
+			continue;
+		}
+
+		int nNoDelay = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&nNoDelay, sizeof(nNoDelay));
+
+		m_SessionLock.Lock();
+		m_Sessions.push_back(s);
+		m_SessionLock.Unlock();
+
+		HandleSession(s).Detach();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ӽ
+//-----------------------------------------------------------------------------
+void DBService::RemoveSession(SOCKET s)
+{
+	m_SessionLock.Lock();
+	for (size_t n = 0; n < m_Sessions.size(); ++n)
+	{
+		if (m_Sessions[n] == s)
+		{
+			m_Sessions[n] = m_Sessions.back();
+			m_Sessions.pop_back();
+			break;
+		}
+	}
+	m_Port.Detach(s);
+	closesocket(s);
+	m_SessionLock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+// һӣ󡢴ظֱϿ
+//-----------------------------------------------------------------------------
+XTask<void> DBService::HandleSession(SOCKET s)
+{
+	co_await m_Port.Schedule();	// ӽ߳еIO߳
+
+	tagDBMsgHead head;
+	std::string body;
+	std::string reply;
+	for (;;)
+	{
+		if (!co_await m_Port.RecvAll(s, &head, sizeof(head)) || head.dwSize > MAX_BODY_SIZE)
+		{
+			break;
+		}
+
+		body.resize(head.dwSize);
+		if (head.dwSize > 0 && !co_await m_Port.RecvAll(s, &body[0], head.dwSize))
+		{
+			break;
+		}
+
+		co_await HandleRequest(head, body);
+
+		// ϢͷϢһη
+		head.dwSize = (DWORD)body.size();
+		reply.assign((const char*)&head, sizeof(head));
+		reply.append(body);
+		if (!co_await m_Port.SendAll(s, reply.data(), (DWORD)reply.size()))
+		{
+			break;
+		}
+	}
+
+	RemoveSession(s);
+}
+
+//-----------------------------------------------------------------------------
+// ڴͨḶַֻ̌߳
+//-----------------------------------------------------------------------------
+void DBService::ShmThread()
+{
+	XTRACE_THREAD_NAME("DBServiceShm");
+
+	XShmChannel::tagShmMsg msg;
+	void* pReserve = nullptr;
+	while (!m_bStop)
+	{
+		// ظͷŲʱȲȡڻԷȻ
+		if (m_lShmPending >= MAX_SHM_PENDING
+			|| (pReserve == nullptr && (pReserve = m_Shm.Alloc(sizeof(tagDBMsgHead))) == nullptr))
+		{
+			Sleep(1);
+			continue;
+		}
+
+		if (m_Shm.Recv(msg, 100))
+		{
+			::InterlockedIncrement(&m_lShmPending);
+			HandleShmRequest(msg, pReserve).Detach();
+			pReserve = nullptr;
+		}
+	}
+	m_Shm.Free(pReserve);
+}
+
+//-----------------------------------------------------------------------------
+// һڴ󣬻ظֱͨ䣬䲻ȣԤ0xFFFE
+// ԷûգʱóIO߳ԺͶͶMAX_SHM_POST_RETRYλͶظ
+//-----------------------------------------------------------------------------
+XTask<void> DBService::HandleShmRequest(XShmChannel::tagShmMsg msg, void* pReserve)
+{
+	co_await m_Port.Schedule();	// ӽ߳еIO߳
+
+	tagDBMsgHead head;
+	std::string body;
+	bool bValid = msg.dwLen >= sizeof(head);
+	if (bValid)
+	{
+		memcpy(&head, msg.pData, sizeof(head));
+		bValid = (head.dwSize == msg.dwLen - sizeof(head));
+		if (bValid)
+		{
+			body.assign((const char*)msg.pData + sizeof(head), head.dwSize);
+		}
+	}
+	m_Shm.Free(msg.pData);
+
+	if (bValid)
+	{
+		co_await HandleRequest(head, body);
+
+		// СظֱԤ飻䣬䲻͸ĻһֻϢͷ0xFFFE
+		size_t nLen = sizeof(head) + body.size();
+		void* pReply = pReserve;
+		if (nLen > XShmChannel::MIN_BLOCK_SIZE)
+		{
+			void* pBig = nLen <= XShmChannel::MAX_MSG_SIZE ? m_Shm.Alloc((DWORD)nLen) : nullptr;
+			if (pBig)
+			{
+				m_Shm.Free(pReserve);
+				pReply = pBig;
+			}
+			else
+			{
+				head.wResult = 0xFFFE;	// ͨŲ»ʱûռ
+				body.clear();
+			}
+		}
+		pReserve = nullptr;
+		head.dwSize = (DWORD)body.size();
+
+		DWORD dwLen = (DWORD)(sizeof(head) + body.size());
+		memcpy(pReply, &head, sizeof(head));
+		memcpy((char*)pReply + sizeof(head), body.data(), body.size());
+		int nRetry = 0;
+		while (!m_Shm.Post(pReply, dwLen, 0))
+		{
+			if (m_bStop || ++nRetry > MAX_SHM_POST_RETRY)
+			{
+				m_Shm.Free(pReply);
+				break;
+			}
+			co_await m_Port.Schedule();
+		}
+	}
+
+	m_Shm.Free(pReserve);	// Чʱû
+	::InterlockedDecrement(&m_lShmPending);
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+XTask<void> DBService::HandleRequest(tagDBMsgHead& head, std::string& body)
+{
+	XTRACE_SCOPE_ARG("DBService::HandleRequest", head.wType);
+
+	head.wResult = 0;
+	switch (head.wType)
+	{
+	case DB_MSG_GET:
+		{
+			std::string value;
+			head.wResult = (co_await m_Store.Get(head.qwKey, value)) ? 0 : 1;
+			body.swap(value);
+		}
+		break;
+
+	case DB_MSG_PUT:
+		head.wResult = (co_await m_Store.Put(head.qwKey, body.data(), (DWORD)body.size())) ? 0 : 1;
+		body.clear();
+		break;
+
+	case DB_MSG_RANK_SET:
+		head.wResult = (co_await SetRank(head.qwKey, head.llParam)) ? 0 : 1;
+		body.clear();
+		break;
+
+	case DB_MSG_RANK_GET:
+		head.llParam = m_RankList.GetRank(head.qwKey);
+		head.wResult = head.llParam ? 0 : 1;
+		body.clear();
+		break;
+
+	case DB_MSG_RANK_TOP:
+	case DB_MSG_RANK_AROUND:
+		{
+			int nCount = (int)fxmin(head.llParam, (long long)MAX_RANK_COUNT);
+			if (head.wType == DB_MSG_RANK_AROUND)
+			{
+				nCount = (int)fxmin(head.llParam, (long long)(MAX_RANK_COUNT / 2));
+			}
+
+			if (nCount <= 0)
+			{
+				head.wResult = 1;
+				body.clear();
+				break;
+			}
+
+			int nMax = head.wType == DB_MSG_RANK_TOP ? nCount : nCount * 2 + 1;
+			body.resize(sizeof(tagRankItem) * nMax);
+			tagRankItem* pItems = (tagRankItem*)&body[0];
+			int nGot = head.wType == DB_MSG_RANK_TOP
+				? m_RankList.GetTop(nCount, pItems)
+				: m_RankList.GetAround((int)head.qwKey, nCount, pItems);
+			body.resize(sizeof(tagRankItem) * nGot);
+		}
+		break;
+
+	case DB_MSG_NAME_BIND:
+	case DB_MSG_NAME_GET:
+		if (body.empty() || body.size() > DB_MAX_NAME_SIZE || memchr(body.data(), 0, body.size()))
+		{
+			head.wResult = 1;
+		}
+		else if (head.wType == DB_MSG_NAME_BIND)
+		{
+			head.wResult = (co_await BindName(body, head.qwKey)) ? 0 : 1;
+		}
+		else
+		{
+			head.wResult = (co_await LookupName(body, head.qwKey)) ? 0 : 1;
+		}
+		body.clear();
+		break;
+
+	case DB_MSG_PATCH:
+		if (head.llParam < 0 || head.llParam >= MAX_SCHEMA || m_Schemas[head.llParam].pfnPatch == nullptr)
+		{
+			head.wResult = 1;
+		}
+		else
+		{
+			const tagSchema& schema = m_Schemas[head.llParam];
+			head.wResult = (co_await m_Store.Patch(head.qwKey, schema.pfnPatch, schema.dwMaxSize, body.data(), (DWORD)body.size())) ? 0 : 1;
+		}
+		body.clear();
+		break;
+
+	case DB_MSG_TRACE:
+		if (head.llParam)
+		{
+			XTrace::SetEnable(true);
+			head.llParam = 0;
+		}
+		else
+		{
+			head.llParam = DumpTrace();
+			head.wResult = head.llParam >= 0 ? 0 : 1;
+		}
+		body.clear();
+		break;
+
+	default:
+		head.wResult = 0xFFFF;
+		body.clear();
+		break;
+	}
+	co_return;
+}
+
+//-----------------------------------------------------------------------------
+// ֣ϣײϱʱʧܣеİ
+//-----------------------------------------------------------------------------
+XTask<bool> DBService::BindName(const std::string& strName, unsigned long long qwKey)
+{
+	unsigned long long qwRecordKey = GetNameRecordKey(strName);
+
+	std::string value;
+	if (co_await m_Store.Get(qwRecordKey, value))
+	{
+		XRecordView<tagDBNameSchema> view(value.data(), (unsigned int)value.size());
+		if (!view.IsValid() || strName != view.Get<ENF_Name>())
+		{
+			co_return false;
+		}
+	}
+
+	XRecordWriter<tagDBNameSchema> writer;
+	writer.Set<ENF_Key>(qwKey);
+	writer.Set<ENF_Name>(strName.c_str());
+	unsigned int dwSize = writer.Finish();
+	if (!(co_await m_Store.Put(qwRecordKey, writer.GetData(), dwSize)))
+	{
+		co_return false;
+	}
+
+	CacheName(strName, qwKey);
+	co_return true;
+}
+
+//-----------------------------------------------------------------------------
+// ֲkey
+//-----------------------------------------------------------------------------
+XTask<bool> DBService::LookupName(const std::string& strName, unsigned long long& qwKey)
+{
+	// פֱӰ飬Findڴ
+	XInternKey key = m_Names.Find(strName.data(), (unsigned int)strName.size());
+	if (key.IsValid())
+	{
+		m_NameLock.Lock();
+		auto it = m_NameKeys.find(key);
+		bool bFound = it != m_NameKeys.end();
+		if (bFound)
+		{
+			qwKey = it->second;
+		}
+		m_NameLock.Unlock();
+
+		if (bFound)
+		{
+			co_return true;
+		}
+	}
+
+	// ڶصֱȡֶΣ
+	std::string value;
+	if (!(co_await m_Store.Get(GetNameRecordKey(strName), value)))
+	{
+		co_return false;
+	}
+
+	XRecordView<tagDBNameSchema> view(value.data(), (unsigned int)value.size());
+	if (!view.IsValid() || strName != view.Get<ENF_Name>())
+	{
+		co_return false;
+	}
+
+	qwKey = view.Get<ENF_Key>();
+	CacheName(strName, qwKey);
+	co_return true;
+}
+
+//-----------------------------------------------------------------------------
+// ǵڴУפʧֻ´λҪ洢
+//-----------------------------------------------------------------------------
+void DBService::CacheName(const std::string& strName, unsigned long long qwKey)
+{
+	XInternKey key = m_Names.Intern(strName.data(), (unsigned int)strName.size());
+	if (!key.IsValid())
+	{
+		return;
+	}
+
+	m_NameLock.Lock();
+	m_NameKeys[key] = qwKey;
+	m_NameLock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+// ÷ڴȸģ̺Żظ
+// д־ʧʱڴѾ·صһ̵ķ
+//-----------------------------------------------------------------------------
+XTask<bool> DBService::SetRank(unsigned long long qwID, long long llScore)
+{
+	if (!m_RankList.Update(qwID, llScore))
+	{
+		co_return false;
+	}
+	co_return co_await m_RankStore.Put(qwID, &llScore, sizeof(llScore));
+}
+
+//-----------------------------------------------------------------------------
+// ӷ־ؽа
+//-----------------------------------------------------------------------------
+bool DBService::LoadRank()
+{
+	return m_RankStore.Scan(&DBService::LoadRankRecord, this);
+}
+
+//-----------------------------------------------------------------------------
+void DBService::LoadRankRecord(void* pParam, unsigned long long qwKey, const std::string& strValue)
+{
+	long long llScore;
+	if (strValue.size() != sizeof(llScore))
+	{
+		printf("DBService: bad rank record %llu\n", qwKey);
+		return;
+	}
+
+	memcpy(&llScore, strValue.data(), sizeof(llScore));
+	((DBService*)pParam)->m_RankList.Update(qwKey, llScore);
+}
+
+#endif // XCORO_SUPPORTED
@@ -0,0 +1,141 @@
+#pragma once
+
+#ifndef __DBSERVICE_H__
+#define __DBSERVICE_H__
+
+#include "DBProtocol.h"
+#include "DBRankList.h"
+#include "DBStore.h"
+#include "XRecordDelta.h"
+#include "XShmChannel.h"
+#include "XString.h"
+#include "XTrace.h"
+
+#if XCORO_SUPPORTED
+
+//-----------------------------------------------------------------------------
+// ݷÿһЭ̣еȴ硢̡ʱ
+//-----------------------------------------------------------------------------
+class DBService
+{
+public:
+	enum
+	{
+		MAX_BODY_SIZE = 1024 * 1024,
+		MAX_RANK_COUNT = 1000,
+		MAX_SHM_PENDING = 1024,		// ڴͨͬʱֻ޲֤ظпռ
+		MAX_SHM_POST_RETRY = 1000,	// ظͶʱͶԷһֱվͶռIO߳
+		MAX_SCHEMA = 64,			// DB_MSG_PATCHļ¼ʽ
+	};
+
+	//-----------------------------------------------------------------------------
+	// ǼDB_MSG_PATCHõļ¼ʽdwSchemaСMAX_SCHEMAStart֮ǰ
+	//-----------------------------------------------------------------------------
+	template<typename Schema>
+	bool RegisterSchema(unsigned int dwSchema)
+	{
+		return RegisterSchema(dwSchema, &XRecordDelta<Schema>::Patch, Schema::MAX_SIZE);
+	}
+	bool RegisterSchema(unsigned int dwSchema, DBStore::DBPatchFunc pfnPatch, unsigned int dwMaxSize);
+
+	//-----------------------------------------------------------------------------
+	// nThreadsIO߳
+	//-----------------------------------------------------------------------------
+	bool Start(unsigned short wPort, const char* szDataFile, int nThreads);
+
+	//-----------------------------------------------------------------------------
+	// ⴴһڴͨͬãStart֮
+	//-----------------------------------------------------------------------------
+	bool StartShm(const char* szName);
+
+	//-----------------------------------------------------------------------------
+	// ֹͣ߳˳
+	//-----------------------------------------------------------------------------
+	void Stop();
+
+	//-----------------------------------------------------------------------------
+	// ֹͣ¼ٲļ.trace.json¼ʧܷ-1
+	// ֻле̵߳¼ҪStop֮ǰ
+	//-----------------------------------------------------------------------------
+	int DumpTrace();
+
+	DBStore& GetStore() { return m_Store; }
+	DBRankList& GetRankList() { return m_RankList; }
+
+	DBService();
+	~DBService();
+
+private:
+	void AcceptThread();
+	void RemoveSession(SOCKET s);
+
+	//-----------------------------------------------------------------------------
+	// һӵȫ
+	//-----------------------------------------------------------------------------
+	XTask<void> HandleSession(SOCKET s);
+
+	//-----------------------------------------------------------------------------
+	// һ󣬻ظдheadbody
+	//-----------------------------------------------------------------------------
+	XTask<void> HandleRequest(tagDBMsgHead& head, std::string& body);
+
+	//-----------------------------------------------------------------------------
+	// ֺͼ¼keyİ󶨣ڴаפ飬ûٶ洢
+	//-----------------------------------------------------------------------------
+	XTask<bool> BindName(const std::string& strName, unsigned long long qwKey);
+	XTask<bool> LookupName(const std::string& strName, unsigned long long& qwKey);
+	void CacheName(const std::string& strName, unsigned long long qwKey);
+
+	//-----------------------------------------------------------------------------
+	// аķһ־keyΪIDΪ8ֽڷʱؽ
+	//-----------------------------------------------------------------------------
+	XTask<bool> SetRank(unsigned long long qwID, long long llScore);
+	bool LoadRank();
+	static void LoadRankRecord(void* pParam, unsigned long long qwKey, const std::string& strValue);
+
+	static unsigned long long GetNameRecordKey(const std::string& strName)
+	{
+		return XHashString(strName.data(), (unsigned int)strName.size()) | DB_NAME_KEY_FLAG;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ڴͨһ߳գÿϢһЭ̴ֱͨظ
+	// ֮ǰΪظԤһСظһ䲻ʱһֻϢͷ0xFFFE
+	//-----------------------------------------------------------------------------
+	void ShmThread();
+	XTask<void> HandleShmRequest(XShmChannel::tagShmMsg msg, void* pReserve);
+
+	// Ǽǵļ¼ʽ
+	struct tagSchema
+	{
+		DBStore::DBPatchFunc	pfnPatch;
+		unsigned int			dwMaxSize;
+	};
+
+	XIoPort						m_Port;
+	DBStore						m_Store;
+	DBRankList					m_RankList;
+	DBStore						m_RankStore;		// ļ.rank
+	std::string					m_strTraceFile;
+	tagSchema					m_Schemas[MAX_SCHEMA];
+
+	SOCKET						m_sListen;
+	std::thread					m_AcceptThread;
+	std::vector<std::thread>	m_IoThreads;
+
+	XMutex						m_SessionLock;
+	std::vector<SOCKET>			m_Sessions;			// ǰӣֹͣʱж
+	bool volatile				m_bStop;
+
+	XInternTable<XAtomMutex>	m_Names;
+	XMutex						m_NameLock;
+	std::unordered_map<XInternKey, unsigned long long, XInternKey::Hasher>	m_NameKeys;	// פȽָֻ
+
+	XShmChannel					m_Shm;
+	std::thread					m_ShmThread;
+	LONG volatile				m_lShmPending;		// ûظĹڴ
+};
+
+#endif // XCORO_SUPPORTED
+
+#endif // !__DBSERVICE_H__
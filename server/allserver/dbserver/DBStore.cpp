@@ -0,0 +1,851 @@
+#include "stdafx.h"
+#include "DBStore.h"
+
+#include <algorithm>
+
+#if XCORO_SUPPORTED
+
+#ifndef _WIN32
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// ¼ͷ
+//-----------------------------------------------------------------------------
+#pragma pack(push, 1)
+struct tagRecordHead
+{
+	unsigned long long	qwKey;
+	DWORD				dwLen;
+};
+
+//-----------------------------------------------------------------------------
+// ļͷʱļĴСԵϲ
+//-----------------------------------------------------------------------------
+struct tagBloomHead
+{
+	unsigned int		dwMagic;
+	unsigned long long	qwDataSize;
+};
+#pragma pack(pop)
+
+#define BLOOM_MAGIC		0x4D4F4C42
+
+#ifdef _WIN32
+
+//-----------------------------------------------------------------------------
+DBFile::DBFile()
+	: m_hFile(INVALID_HANDLE_VALUE)
+	, m_qwSize(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Open(const char* szFile)
+{
+	m_hFile = ::CreateFileA(szFile, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER liSize;
+	if (!::GetFileSizeEx(m_hFile, &liSize))
+	{
+		Close();
+		return false;
+	}
+	m_qwSize = liSize.QuadPart;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void DBFile::Close()
+{
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::ReadAt(unsigned long long qwOffset, void* pBuf, DWORD dwLen)
+{
+	OVERLAPPED ov;
+	ZeroMemory(&ov, sizeof(ov));
+	ov.Offset = (DWORD)qwOffset;
+	ov.OffsetHigh = (DWORD)(qwOffset >> 32);
+
+	DWORD dwRead = 0;
+	return ::ReadFile(m_hFile, pBuf, dwLen, &dwRead, &ov) && dwRead == dwLen;
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Append(const void* pBuf, DWORD dwLen)
+{
+	OVERLAPPED ov;
+	ZeroMemory(&ov, sizeof(ov));
+	ov.Offset = (DWORD)m_qwSize;
+	ov.OffsetHigh = (DWORD)(m_qwSize >> 32);
+
+	DWORD dwWritten = 0;
+	if (!::WriteFile(m_hFile, pBuf, dwLen, &dwWritten, &ov) || dwWritten != dwLen)
+	{
+		return false;
+	}
+	m_qwSize += dwLen;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Sync()
+{
+	return ::FlushFileBuffers(m_hFile) != FALSE;
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Truncate(unsigned long long qwSize)
+{
+	LARGE_INTEGER liSize;
+	liSize.QuadPart = (LONGLONG)qwSize;
+	if (!::SetFilePointerEx(m_hFile, liSize, NULL, FILE_BEGIN) || !::SetEndOfFile(m_hFile))
+	{
+		return false;
+	}
+	m_qwSize = qwSize;
+	return true;
+}
+
+#else
+
+//-----------------------------------------------------------------------------
+DBFile::DBFile()
+	: m_nFile(-1)
+	, m_qwSize(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Open(const char* szFile)
+{
+	m_nFile = open(szFile, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (m_nFile < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(m_nFile, &st) != 0)
+	{
+		Close();
+		return false;
+	}
+	m_qwSize = st.st_size;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void DBFile::Close()
+{
+	if (m_nFile >= 0)
+	{
+		close(m_nFile);
+		m_nFile = -1;
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::ReadAt(unsigned long long qwOffset, void* pBuf, DWORD dwLen)
+{
+	return pread(m_nFile, pBuf, dwLen, (off_t)qwOffset) == (ssize_t)dwLen;
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Append(const void* pBuf, DWORD dwLen)
+{
+	if (pwrite(m_nFile, pBuf, dwLen, (off_t)m_qwSize) != (ssize_t)dwLen)
+	{
+		return false;
+	}
+	m_qwSize += dwLen;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Sync()
+{
+	return fdatasync(m_nFile) == 0;
+}
+
+//-----------------------------------------------------------------------------
+bool DBFile::Truncate(unsigned long long qwSize)
+{
+	if (ftruncate(m_nFile, (off_t)qwSize) != 0)
+	{
+		return false;
+	}
+	m_qwSize = qwSize;
+	return true;
+}
+
+#endif // _WIN32
+
+//-----------------------------------------------------------------------------
+DBFile::~DBFile()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+DBStore::DBStore()
+	: m_pPort(nullptr)
+	, m_nCacheHand(0)
+	, m_nCacheMax(0)
+	, m_pBloom(nullptr)
+	, m_bBloomBuilding(false)
+	, m_bBloomRequest(false)
+	, m_bStop(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+DBStore::~DBStore()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+bool DBStore::Open(XIoPort* pPort, const char* szFile, int nCacheMax, int nDiskThreads)
+{
+	if (!m_File.Open(szFile))
+	{
+		return false;
+	}
+
+	// ˳ɨؽβļ¼ص
+	unsigned long long qwOffset = 0;
+	unsigned long long qwSize = m_File.GetSize();
+	tagRecordHead head;
+	while (qwOffset + sizeof(head) <= qwSize && m_File.ReadAt(qwOffset, &head, sizeof(head)))
+	{
+		if (qwOffset + sizeof(head) + head.dwLen > qwSize)
+		{
+			printf("DBStore: truncated record at %llu\n", qwOffset);
+			break;
+		}
+
+		tagRecordPos& pos = m_Index[head.qwKey];
+		pos.qwOffset = qwOffset + sizeof(head);
+		pos.dwLen = head.dwLen;
+		qwOffset += sizeof(head) + head.dwLen;
+	}
+
+	// صĻ¼¼ڲȱ¼棬´δʱһ𵱳ɻ
+	if (qwOffset < qwSize)
+	{
+		if (!m_File.Truncate(qwOffset) || !m_File.Sync())
+		{
+			printf("DBStore: truncate %s to %llu failed\n", szFile, qwOffset);
+			m_Index.clear();
+			m_File.Close();
+			return false;
+		}
+	}
+
+	m_strBloomFile = szFile;
+	m_strBloomFile.Append(".bloom", 6);
+	LoadBloom();
+
+	m_pPort = pPort;
+	m_nCacheMax = nCacheMax;
+	m_bStop = false;
+	for (int n = 0; n < nDiskThreads; ++n)
+	{
+		m_DiskThreads.emplace_back(&DBStore::DiskThread, this);
+	}
+	m_LogThread = std::thread(&DBStore::LogThread, this);
+	m_BloomThread = std::thread(&DBStore::BloomThread, this);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// رգǰӦѾ
+//-----------------------------------------------------------------------------
+void DBStore::Close()
+{
+	{
+		std::lock_guard<std::mutex> lockDisk(m_DiskLock);
+		std::lock_guard<std::mutex> lockLog(m_LogLock);
+		std::lock_guard<std::mutex> lockBloom(m_BloomLock);
+		m_bStop = true;
+	}
+	m_DiskCond.notify_all();
+	m_LogCond.notify_all();
+	m_BloomCond.notify_all();
+
+	for (auto& th : m_DiskThreads)
+	{
+		th.join();
+	}
+	m_DiskThreads.clear();
+
+	if (m_LogThread.joinable())
+	{
+		m_LogThread.join();
+	}
+
+	if (m_BloomThread.joinable())
+	{
+		m_BloomThread.join();
+	}
+
+	if (m_pBloom)
+	{
+		SaveBloom();
+		XBloomFilter::Destroy(m_pBloom);
+		m_pBloom = nullptr;
+	}
+	m_BloomPending.clear();
+	m_bBloomBuilding = false;
+
+	m_File.Close();
+}
+
+//-----------------------------------------------------------------------------
+// ȡ
+//-----------------------------------------------------------------------------
+XTask<bool> DBStore::Get(unsigned long long qwKey, std::string& strValue)
+{
+	// ˵ûоһûУֻһУʧûйʱȥ
+	{
+		XEpochGuard guard;
+		XBloomFilter* pBloom = m_pBloom;
+		if (pBloom && !pBloom->MayContain(qwKey))
+		{
+			co_return false;
+		}
+	}
+
+	tagRecordPos pos;
+	m_Lock.Lock();
+	auto itCache = m_Cache.find(qwKey);
+	if (itCache != m_Cache.end())
+	{
+		strValue = itCache->second.strValue;
+		m_CacheSlots[itCache->second.nSlot].bRef = true;
+		m_Lock.Unlock();
+		co_return true;
+	}
+
+	auto itIndex = m_Index.find(qwKey);
+	if (itIndex == m_Index.end())
+	{
+		m_Lock.Unlock();
+		co_return false;
+	}
+	pos = itIndex->second;
+	m_Lock.Unlock();
+
+	// 治У߳
+	XAsyncResult<bool> result(m_pPort);
+	{
+		std::lock_guard<std::mutex> lock(m_DiskLock);
+		tagDiskRead read = { pos, &strValue, &result };
+		m_DiskQueue.push_back(read);
+	}
+	m_DiskCond.notify_one();
+
+	bool bOK = co_await result;
+	if (bOK)
+	{
+		CacheInsert(qwKey, pos, strValue);
+	}
+	co_return bOK;
+}
+
+//-----------------------------------------------------------------------------
+// д
+//-----------------------------------------------------------------------------
+XTask<bool> DBStore::Put(unsigned long long qwKey, const void* pData, DWORD dwLen)
+{
+	co_return (co_await Write(qwKey, pData, dwLen)) >= 0;
+}
+
+//-----------------------------------------------------------------------------
+// ޸
+//-----------------------------------------------------------------------------
+XTask<bool> DBStore::Patch(unsigned long long qwKey, DBPatchFunc pfnPatch, unsigned int dwMaxSize, const void* pDelta, DWORD dwDeltaLen)
+{
+	// ͬһkeyĶдܽǰڸľŶӣֵʱǰһ
+	m_Lock.Lock();
+	auto ret = m_PatchKeys.emplace(qwKey, std::deque<XAsyncResult<bool>*>());
+	if (!ret.second)
+	{
+		XAsyncResult<bool> turn(m_pPort);
+		ret.first->second.push_back(&turn);
+		m_Lock.Unlock();
+		co_await turn;
+	}
+	else
+	{
+		m_Lock.Unlock();
+	}
+
+	bool bOK = false;
+	std::string strValue;
+	if (co_await Get(qwKey, strValue))
+	{
+		// 䳤ֶα䳤ʱ¼󣬰ʽռ
+		unsigned int dwLen = (unsigned int)strValue.size();
+		strValue.resize(fxmax(dwLen, dwMaxSize));
+		dwLen = pfnPatch(&strValue[0], (unsigned int)strValue.size(), pDelta, dwDeltaLen);
+		if (dwLen)
+		{
+			strValue.resize(dwLen);
+			long long llOffset = co_await Write(qwKey, strValue.data(), dwLen);
+			if (llOffset >= 0)
+			{
+				tagRecordPos pos;
+				pos.qwOffset = llOffset;
+				pos.dwLen = dwLen;
+				CacheInsert(qwKey, pos, strValue);
+				bOK = true;
+			}
+		}
+	}
+
+	// һŶӵ
+	XAsyncResult<bool>* pNext = nullptr;
+	m_Lock.Lock();
+	auto it = m_PatchKeys.find(qwKey);
+	if (it->second.empty())
+	{
+		m_PatchKeys.erase(it);
+	}
+	else
+	{
+		pNext = it->second.front();
+		it->second.pop_front();
+	}
+	m_Lock.Unlock();
+
+	if (pNext)
+	{
+		pNext->SetResult(true);
+	}
+	co_return bOK;
+}
+
+//-----------------------------------------------------------------------------
+// д־
+//-----------------------------------------------------------------------------
+XTask<long long> DBStore::Write(unsigned long long qwKey, const void* pData, DWORD dwLen)
+{
+	XAsyncResult<long long> result(m_pPort);
+	{
+		std::lock_guard<std::mutex> lock(m_LogLock);
+		tagLogWrite write = { qwKey, pData, dwLen, &result };
+		m_LogQueue.push_back(write);
+	}
+	m_LogCond.notify_one();
+
+	long long llOffset = co_await result;
+	if (llOffset < 0)
+	{
+		co_return -1;
+	}
+
+	// дͬһkeyʱ˳򲻶ֻļп
+	m_Lock.Lock();
+	auto ret = m_Index.emplace(qwKey, tagRecordPos());
+	if (ret.second)
+	{
+		BloomAdd(qwKey);
+	}
+
+	tagRecordPos& pos = ret.first->second;
+	if ((unsigned long long)llOffset > pos.qwOffset)
+	{
+		pos.qwOffset = llOffset;
+		pos.dwLen = dwLen;
+		CacheErase(qwKey);
+	}
+	m_Lock.Unlock();
+	co_return llOffset;
+}
+
+//-----------------------------------------------------------------------------
+// ɨ
+//-----------------------------------------------------------------------------
+bool DBStore::Scan(DBScanFunc pfnScan, void* pParam)
+{
+	std::vector<std::pair<unsigned long long, tagRecordPos> > records;
+	m_Lock.Lock();
+	records.reserve(m_Index.size());
+	for (auto it = m_Index.begin(); it != m_Index.end(); ++it)
+	{
+		records.emplace_back(it->first, it->second);
+	}
+	m_Lock.Unlock();
+
+	// λ˳ļ
+	std::sort(records.begin(), records.end(), [](const std::pair<unsigned long long, tagRecordPos>& a, const std::pair<unsigned long long, tagRecordPos>& b)
+	{
+		return a.second.qwOffset < b.second.qwOffset;
+	});
+
+	std::string strValue;
+	for (size_t n = 0; n < records.size(); ++n)
+	{
+		const tagRecordPos& pos = records[n].second;
+		strValue.resize(pos.dwLen);
+		if (pos.dwLen > 0 && !m_File.ReadAt(pos.qwOffset, &strValue[0], pos.dwLen))
+		{
+			return false;
+		}
+		pfnScan(pParam, records[n].first, strValue);
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+int DBStore::GetCount()
+{
+	m_Lock.Lock();
+	int nCount = (int)m_Index.size();
+	m_Lock.Unlock();
+	return nCount;
+}
+
+//-----------------------------------------------------------------------------
+// ߳
+//-----------------------------------------------------------------------------
+void DBStore::DiskThread()
+{
+	XTRACE_THREAD_NAME("DBStoreDisk");
+
+	std::vector<tagDiskRead> reads;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_DiskLock);
+			m_DiskCond.wait(lock, [this]() { return m_bStop || !m_DiskQueue.empty(); });
+			if (m_DiskQueue.empty())
+			{
+				return;
+			}
+			reads.swap(m_DiskQueue);
+		}
+
+		for (size_t n = 0; n < reads.size(); ++n)
+		{
+			XTRACE_SCOPE("DBStore::DiskRead");
+			tagDiskRead& read = reads[n];
+			read.pValue->resize(read.Pos.dwLen);
+			bool bOK = read.Pos.dwLen == 0 || m_File.ReadAt(read.Pos.qwOffset, &(*read.pValue)[0], read.Pos.dwLen);
+			read.pResult->SetResult(bOK);
+		}
+		reads.clear();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ־̣߳һдһ
+//-----------------------------------------------------------------------------
+void DBStore::LogThread()
+{
+	XTRACE_THREAD_NAME("DBStoreLog");
+
+	std::vector<tagLogWrite> writes;
+	std::vector<char> buffer;
+	std::vector<long long> offsets;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_LogLock);
+			m_LogCond.wait(lock, [this]() { return m_bStop || !m_LogQueue.empty(); });
+			if (m_LogQueue.empty())
+			{
+				return;
+			}
+			writes.swap(m_LogQueue);
+		}
+
+		XTRACE_SCOPE_ARG("DBStore::LogFlush", writes.size());
+
+		// ƴһд
+		unsigned long long qwBase = m_File.GetSize();
+		buffer.clear();
+		offsets.clear();
+		for (size_t n = 0; n < writes.size(); ++n)
+		{
+			tagRecordHead head;
+			head.qwKey = writes[n].qwKey;
+			head.dwLen = writes[n].dwLen;
+			offsets.push_back((long long)(qwBase + buffer.size() + sizeof(head)));
+			buffer.insert(buffer.end(), (const char*)&head, (const char*)&head + sizeof(head));
+			buffer.insert(buffer.end(), (const char*)writes[n].pData, (const char*)writes[n].pData + writes[n].dwLen);
+		}
+
+		bool bOK = m_File.Append(buffer.data(), (DWORD)buffer.size()) && m_File.Sync();
+		for (size_t n = 0; n < writes.size(); ++n)
+		{
+			writes[n].pResult->SetResult(bOK ? offsets[n] : -1);
+		}
+		writes.clear();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ؽ̣߳פDBStoreֻһ
+// keyʱ¹ʱڼ¼ӵkeym_BloomPendingǰȥ
+// ʱXEpoch::Flushµľɹ˳߳µĽڵ㲻õȱRetireܹһ
+//-----------------------------------------------------------------------------
+void DBStore::BloomThread()
+{
+	XTRACE_THREAD_NAME("DBStoreBloom");
+
+	std::vector<unsigned long long> keys;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_BloomLock);
+			if (!m_BloomCond.wait_for(lock, std::chrono::milliseconds(BLOOM_FLUSH_MS), [this]() { return m_bStop || m_bBloomRequest; }))
+			{
+				lock.unlock();
+				XEpoch::Flush();
+				continue;
+			}
+			if (m_bStop)
+			{
+				return;
+			}
+			m_bBloomRequest = false;
+		}
+
+		XTRACE_SCOPE("DBStore::BloomRebuild");
+
+		m_Lock.Lock();
+		keys.clear();
+		keys.reserve(m_Index.size());
+		for (auto it = m_Index.begin(); it != m_Index.end(); ++it)
+		{
+			keys.push_back(it->first);
+		}
+		m_Lock.Unlock();
+
+		XBloomFilter* pNew = XBloomFilter::Create((unsigned int)keys.size() * 2);
+		if (pNew == nullptr)
+		{
+			// ɵļãжһЩѣɵѾڼ¼ӵkey´γʱ
+			m_Lock.Lock();
+			m_BloomPending.clear();
+			m_bBloomBuilding = false;
+			m_Lock.Unlock();
+			continue;
+		}
+		for (size_t n = 0; n < keys.size(); ++n)
+		{
+			pNew->Add(keys[n]);
+		}
+
+		m_Lock.Lock();
+		for (size_t n = 0; n < m_BloomPending.size(); ++n)
+		{
+			pNew->Add(m_BloomPending[n]);
+		}
+		m_BloomPending.clear();
+		XBloomFilter* pOld = (XBloomFilter*)::InterlockedExchangePointer((void* volatile*)&m_pBloom, pNew);
+		m_bBloomBuilding = false;
+		m_Lock.Unlock();
+
+		if (pOld)
+		{
+			XEpoch::Retire(pOld);
+		}
+		XEpoch::Flush();	// ûжʱ黹еĻ´ο
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ֮ǰʧʱ֪ͨؽ
+//-----------------------------------------------------------------------------
+void DBStore::BloomAdd(unsigned long long qwKey)
+{
+	if (m_pBloom)
+	{
+		m_pBloom->Add(qwKey);
+	}
+
+	if (m_bBloomBuilding)
+	{
+		m_BloomPending.push_back(qwKey);
+	}
+	else if (m_pBloom == nullptr || m_Index.size() > m_pBloom->GetCapacity())
+	{
+		m_bBloomBuilding = true;
+		{
+			std::lock_guard<std::mutex> lock(m_BloomLock);
+			m_bBloomRequest = true;
+		}
+		m_BloomCond.notify_one();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+void DBStore::LoadBloom()
+{
+	FILE* fp = fopen(m_strBloomFile.c_str(), "rb");
+	if (fp)
+	{
+		tagBloomHead head;
+		if (fread(&head, sizeof(head), 1, fp) == 1 && head.dwMagic == BLOOM_MAGIC && head.qwDataSize == m_File.GetSize())
+		{
+			m_pBloom = XBloomFilter::Load(fp);
+		}
+		fclose(fp);
+	}
+
+	// ĲҪһؽ
+	if (m_pBloom && m_pBloom->GetCapacity() < m_Index.size())
+	{
+		XBloomFilter::Destroy(m_pBloom);
+		m_pBloom = nullptr;
+	}
+
+	if (m_pBloom == nullptr)
+	{
+		m_pBloom = XBloomFilter::Create((unsigned int)m_Index.size() * 2);
+		if (m_pBloom == nullptr)
+		{
+			printf("DBStore: bloom filter alloc failed, lookups go to the index\n");
+			return;
+		}
+		for (auto it = m_Index.begin(); it != m_Index.end(); ++it)
+		{
+			m_pBloom->Add(it->first);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// дʧ´ʱؽ
+//-----------------------------------------------------------------------------
+void DBStore::SaveBloom()
+{
+	FILE* fp = fopen(m_strBloomFile.c_str(), "wb");
+	if (fp == nullptr)
+	{
+		return;
+	}
+
+	tagBloomHead head;
+	head.dwMagic = BLOOM_MAGIC;
+	head.qwDataSize = m_File.GetSize();
+	bool bOK = fwrite(&head, sizeof(head), 1, fp) == 1 && m_pBloom->Save(fp);
+	fclose(fp);
+
+	if (!bOK)
+	{
+		remove(m_strBloomFile.c_str());
+	}
+}
+
+//-----------------------------------------------------------------------------
+// 뻺棬˰CLOCK̭ûй
+// ڼ䱻дĲţû
+//-----------------------------------------------------------------------------
+void DBStore::CacheInsert(unsigned long long qwKey, const tagRecordPos& pos, const std::string& strValue)
+{
+	if (m_nCacheMax <= 0)
+	{
+		return;
+	}
+
+	m_Lock.Lock();
+	auto itIndex = m_Index.find(qwKey);
+	if (itIndex == m_Index.end() || itIndex->second.qwOffset != pos.qwOffset)
+	{
+		m_Lock.Unlock();
+		return;
+	}
+
+	// Эͬʱͬһkeyʱֻռһ
+	auto itCache = m_Cache.find(qwKey);
+	if (itCache != m_Cache.end())
+	{
+		itCache->second.strValue = strValue;
+		m_Lock.Unlock();
+		return;
+	}
+
+	int nSlot = CacheSlot();
+	tagCacheSlot& slot = m_CacheSlots[nSlot];
+	slot.qwKey = qwKey;
+	slot.bRef = false;	// һβеڶλ
+
+	tagCacheEntry& entry = m_Cache[qwKey];
+	entry.strValue = strValue;
+	entry.nSlot = nSlot;
+	m_Lock.Unlock();
+}
+
+//-----------------------------------------------------------------------------
+void DBStore::CacheErase(unsigned long long qwKey)
+{
+	auto itCache = m_Cache.find(qwKey);
+	if (itCache == m_Cache.end())
+	{
+		return;
+	}
+
+	m_CacheFree.push_back(itCache->second.nSlot);
+	m_Cache.erase(itCache);
+}
+
+//-----------------------------------------------------------------------------
+// ղ۶m_CacheFreeϵĶãָתһȦڱضbRefɨȦ
+//-----------------------------------------------------------------------------
+int DBStore::CacheSlot()
+{
+	if (!m_CacheFree.empty())
+	{
+		int nSlot = m_CacheFree.back();
+		m_CacheFree.pop_back();
+		return nSlot;
+	}
+
+	if ((int)m_CacheSlots.size() < m_nCacheMax)
+	{
+		m_CacheSlots.push_back(tagCacheSlot());
+		return (int)m_CacheSlots.size() - 1;
+	}
+
+	for (;;)
+	{
+		int nSlot = m_nCacheHand;
+		m_nCacheHand = (m_nCacheHand + 1) % (int)m_CacheSlots.size();
+
+		tagCacheSlot& slot = m_CacheSlots[nSlot];
+		if (slot.bRef)
+		{
+			slot.bRef = false;
+			continue;
+		}
+
+		m_Cache.erase(slot.qwKey);
+		return nSlot;
+	}
+}
+
+#endif // XCORO_SUPPORTED
@@ -0,0 +1,223 @@
+#pragma once
+
+#ifndef __DBSTORE_H__
+#define __DBSTORE_H__
+
+#include "XIoPort.h"
+#include "XBloomFilter.h"
+#include "XEpoch.h"
+#include "XString.h"
+
+#if XCORO_SUPPORTED
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+//-----------------------------------------------------------------------------
+// ֻ׷ӵļ
+//-----------------------------------------------------------------------------
+class DBFile
+{
+public:
+	bool Open(const char* szFile);
+	void Close();
+
+	//-----------------------------------------------------------------------------
+	// ָλöԶ߳ͬʱ
+	//-----------------------------------------------------------------------------
+	bool ReadAt(unsigned long long qwOffset, void* pBuf, DWORD dwLen);
+
+	//-----------------------------------------------------------------------------
+	// дļβֻ־̵߳
+	//-----------------------------------------------------------------------------
+	bool Append(const void* pBuf, DWORD dwLen);
+
+	//-----------------------------------------------------------------------------
+	// 
+	//-----------------------------------------------------------------------------
+	bool Sync();
+
+	//-----------------------------------------------------------------------------
+	// ضϵָȣֻڴʱ
+	//-----------------------------------------------------------------------------
+	bool Truncate(unsigned long long qwSize);
+
+	unsigned long long GetSize() { return m_qwSize; }
+
+	DBFile();
+	~DBFile();
+
+private:
+#ifdef _WIN32
+	HANDLE				m_hFile;
+#else
+	int					m_nFile;
+#endif
+	unsigned long long	m_qwSize;
+};
+
+//-----------------------------------------------------------------------------
+// ¼洢
+// ļ־ÿ¼Ϊ [qwKey 8][dwLen 4][]ͬһkeyһΪ׼
+// ڴȫ¼λһ޵Ļ棬治ʱɴ̶߳ȡ
+// д־߳дļ̣̺֪ͨȴЭ̣ύ
+// ǰ浲һ¡ڵkeyܷ
+// ¼2䣬ɳפĹ߳ؽرʱ浽ļԱ
+//-----------------------------------------------------------------------------
+class DBStore
+{
+public:
+	//-----------------------------------------------------------------------------
+	// ļؽ
+	//-----------------------------------------------------------------------------
+	bool Open(XIoPort* pPort, const char* szFile, int nCacheMax = 100000, int nDiskThreads = 4);
+	void Close();
+
+	//-----------------------------------------------------------------------------
+	// ȡڷfalse
+	//-----------------------------------------------------------------------------
+	XTask<bool> Get(unsigned long long qwKey, std::string& strValue);
+
+	//-----------------------------------------------------------------------------
+	// д룬̺󷵻
+	//-----------------------------------------------------------------------------
+	XTask<bool> Put(unsigned long long qwKey, const void* pData, DWORD dwLen);
+
+	//-----------------------------------------------------------------------------
+	// ֶβ޸ļ¼pfnPatchΪXRecordDelta<Schema>::PatchdwMaxSizeΪSchema::MAX_SIZE
+	// ͬһkeyPatchŶִУ¼д־̺ڻ
+	// ¼ڻʱfalse¼
+	//-----------------------------------------------------------------------------
+	typedef unsigned int (*DBPatchFunc)(void* pRecord, unsigned int dwCapacity, const void* pDelta, unsigned int dwDeltaLen);
+	XTask<bool> Patch(unsigned long long qwKey, DBPatchFunc pfnPatch, unsigned int dwMaxSize, const void* pDelta, DWORD dwDeltaLen);
+
+	//-----------------------------------------------------------------------------
+	// ļ˳ͬÿkey¼¼ʧܷfalse
+	// ֻʱûждؽڴĽṹ
+	//-----------------------------------------------------------------------------
+	typedef void (*DBScanFunc)(void* pParam, unsigned long long qwKey, const std::string& strValue);
+	bool Scan(DBScanFunc pfnScan, void* pParam);
+
+	int GetCount();
+
+	DBStore();
+	~DBStore();
+
+private:
+	enum
+	{
+		BLOOM_FLUSH_MS = 1000,	// ߳̿ʱXEpochŵĽڵļ
+	};
+
+	// ¼ļеλ
+	struct tagRecordPos
+	{
+		unsigned long long	qwOffset;	// ݵλã¼ͷ
+		DWORD				dwLen;
+	};
+
+	// 
+	struct tagCacheEntry
+	{
+		std::string			strValue;
+		int					nSlot;		// m_CacheSlotsеλ
+	};
+
+	// CLOCKϵһʱbRefָɨʱûõḽ̌
+	struct tagCacheSlot
+	{
+		unsigned long long	qwKey;
+		bool				bRef;
+	};
+
+	// ̶
+	struct tagDiskRead
+	{
+		tagRecordPos				Pos;
+		std::string*				pValue;
+		XAsyncResult<bool>*			pResult;
+	};
+
+	// ־д󣬽ΪļеλãʧΪ-1
+	struct tagLogWrite
+	{
+		unsigned long long			qwKey;
+		const void*					pData;
+		DWORD						dwLen;
+		XAsyncResult<long long>*	pResult;
+	};
+
+	//-----------------------------------------------------------------------------
+	// д־ļеλãʧܷ-1
+	//-----------------------------------------------------------------------------
+	XTask<long long> Write(unsigned long long qwKey, const void* pData, DWORD dwLen);
+
+	void DiskThread();
+	void LogThread();
+	void BloomThread();
+	void CacheInsert(unsigned long long qwKey, const tagRecordPos& pos, const std::string& strValue);
+
+	//-----------------------------------------------------------------------------
+	// ӻȥҪm_Lock
+	//-----------------------------------------------------------------------------
+	void CacheErase(unsigned long long qwKey);
+
+	//-----------------------------------------------------------------------------
+	// ȡһղۣ˰CLOCK̭Ҫm_Lock
+	//-----------------------------------------------------------------------------
+	int CacheSlot();
+
+	//-----------------------------------------------------------------------------
+	// keyӽҪm_Lock
+	//-----------------------------------------------------------------------------
+	void BloomAdd(unsigned long long qwKey);
+
+	//-----------------------------------------------------------------------------
+	// ̵ĹļԲϾͰؽ
+	//-----------------------------------------------------------------------------
+	void LoadBloom();
+	void SaveBloom();
+
+	XIoPort*										m_pPort;
+	DBFile											m_File;
+
+	XMutex											m_Lock;			// ͻ
+	std::unordered_map<unsigned long long, tagRecordPos>	m_Index;
+	std::unordered_map<unsigned long long, tagCacheEntry>	m_Cache;
+	std::vector<tagCacheSlot>						m_CacheSlots;
+	std::vector<int>								m_CacheFree;	// PutɾճĲ
+	int												m_nCacheHand;
+	int												m_nCacheMax;
+
+	std::unordered_map<unsigned long long, std::deque<XAsyncResult<bool>*> >	m_PatchKeys;	// PatchkeyŶӵЭ
+
+	XBloomFilter* volatile							m_pBloom;		// ĽXEpoch
+	std::vector<unsigned long long>					m_BloomPending;	// ؽڼ¼ӵkey
+	bool											m_bBloomBuilding;
+	XSmallString									m_strBloomFile;
+
+	std::mutex										m_DiskLock;
+	std::condition_variable							m_DiskCond;
+	std::vector<tagDiskRead>						m_DiskQueue;
+	std::vector<std::thread>						m_DiskThreads;
+
+	std::mutex										m_LogLock;
+	std::condition_variable							m_LogCond;
+	std::vector<tagLogWrite>						m_LogQueue;
+	std::thread										m_LogThread;
+
+	std::mutex										m_BloomLock;
+	std::condition_variable							m_BloomCond;
+	bool											m_bBloomRequest;
+	std::thread										m_BloomThread;
+
+	bool											m_bStop;
+};
+
+#endif // XCORO_SUPPORTED
+
+#endif // !__DBSTORE_H__
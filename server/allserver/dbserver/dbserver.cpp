@@ -3,11 +3,89 @@
 
 #include "stdafx.h"
 #include "XMemCache.h"
+#include "DBService.h"
 
 XMemCache<XAtomMutex>*	g_pMemCache = nullptr;
 
-int main()
+int main(int argc, char* argv[])
 {
+    g_pMemCache = new XMemCache<XAtomMutex>();	// ްڴ涨
+
+#if XCORO_SUPPORTED
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        return 1;
+    }
+#endif
+
+    // dbserver [-trace] [˿] [ļ] [ڴͨ]
+    // -traceʼ¼¼˳ǰдļ.trace.jsonҲDB_MSG_TRACE
+    bool bTrace = false;
+    const char* szArgs[3] = { nullptr, nullptr, nullptr };
+    int nArgs = 0;
+    for (int n = 1; n < argc; ++n)
+    {
+        if (strcmp(argv[n], "-trace") == 0)
+        {
+            bTrace = true;
+        }
+        else if (nArgs < 3)
+        {
+            szArgs[nArgs++] = argv[n];
+        }
+    }
+
+    unsigned short wPort = szArgs[0] ? (unsigned short)atoi(szArgs[0]) : 9100;
+    const char* szDataFile = szArgs[1] ? szArgs[1] : "dbserver.dat";
+    const char* szShmName = szArgs[2];
+    if (bTrace)
+    {
+        XTrace::SetEnable(true);
+    }
+
+    // ϴбĸߴֵԤڴأûʱ
+    std::string strProfile = std::string(szDataFile) + ".memprofile";
+    int nWarm = g_pMemCache->Prewarm(strProfile.c_str(), 4);
+    if (nWarm > 0)
+    {
+        printf("dbserver: prewarmed %d blocks from %s\n", nWarm, strProfile.c_str());
+    }
+
+    DBService service;
+    if (!service.Start(wPort, szDataFile, 4))
+    {
+        return 1;
+    }
+    g_pMemCache->SetAdaptive(true);
+
+    if (szShmName && !service.StartShm(szShmName))
+    {
+        printf("dbserver: create shared memory channel %s failed\n", szShmName);
+    }
+
+    printf("dbserver listening on %u, press enter to quit\n", wPort);
+    getchar();
+    if (XTrace::IsEnabled())
+    {
+        service.DumpTrace();	// IO߳˳ʱͷŸԵĻ
+    }
+    service.Stop();
+    g_pMemCache->SetAdaptive(false);
+
+    if (!g_pMemCache->SaveProfile(strProfile.c_str()))
+    {
+        printf("dbserver: save memory profile %s failed\n", strProfile.c_str());
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+#else
+    printf("dbserver needs C++20 coroutines (/std:c++latest)\n");
+#endif
+
     return 0;
 }
 
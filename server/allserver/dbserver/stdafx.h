@@ -5,10 +5,12 @@
 
 #pragma once
 
-#include "targetver.h"
+#ifdef _WIN32
+#	include "targetver.h"
+#	include <tchar.h>
+#endif
 
 #include <stdio.h>
-#include <tchar.h>
 
 
 
@@ -0,0 +1,191 @@
+#pragma once
+
+#ifndef __XBLOOMFILTER_H__
+#define __XBLOOMFILTER_H__
+
+#include "XMemCache.h"
+#include <stdio.h>
+#ifdef __AVX2__
+#	include <immintrin.h>
+#endif
+
+extern XMemCache<XAtomMutex>*	g_pMemCache;
+
+//-----------------------------------------------------------------------------
+// 鲼¡
+// ÿkeyֻһ32ֽڵĿ8ָ1λѯֻһ
+// 8λ8ͬһ32λϣõAVX2ʱһ˷ָ
+// ÿkey 12λʱԼ0.5%
+//
+// AddҪеãMayContainԺAddλֻԲ©
+// һMCALLOCڴ棬ֱӽXEpoch::Retire
+//-----------------------------------------------------------------------------
+class XBloomFilter
+{
+public:
+	enum
+	{
+		BLOCK_WORDS		= 8,
+		BITS_PER_KEY	= 12,
+		MIN_BLOCKS		= 64,
+	};
+
+	//-----------------------------------------------------------------------------
+	// ԤkeyMIN_BLOCKS飬Ȼ
+	//-----------------------------------------------------------------------------
+	static XBloomFilter* Create(unsigned int dwCapacity);
+	static void Destroy(XBloomFilter* pFilter) { MCFREE(pFilter); }
+
+	//-----------------------------------------------------------------------------
+	// SaveдļʽԷnullptr
+	//-----------------------------------------------------------------------------
+	static XBloomFilter* Load(FILE* fp);
+	bool Save(FILE* fp) const;
+
+	void Add(unsigned long long qwKey);
+
+	//-----------------------------------------------------------------------------
+	// falseʾһû
+	//-----------------------------------------------------------------------------
+	bool MayContain(unsigned long long qwKey) const;
+
+	unsigned int GetCapacity() const { return m_dwCapacity; }
+
+private:
+	struct tagBlock
+	{
+		unsigned int	dwWord[BLOCK_WORDS];
+	};
+
+	//-----------------------------------------------------------------------------
+	// 32λѡ飬32λѡڵλ
+	//-----------------------------------------------------------------------------
+	static unsigned long long Hash(unsigned long long qwKey)
+	{
+		qwKey ^= qwKey >> 30;
+		qwKey *= 0xBF58476D1CE4E5B9ULL;
+		qwKey ^= qwKey >> 27;
+		qwKey *= 0x94D049BB133111EBULL;
+		return qwKey ^ (qwKey >> 31);
+	}
+
+	static unsigned int GetBlockCount(unsigned int dwCapacity)
+	{
+		unsigned long long qwBlocks = ((unsigned long long)dwCapacity * BITS_PER_KEY + 255) / 256;
+		return qwBlocks < MIN_BLOCKS ? (unsigned int)MIN_BLOCKS : (unsigned int)qwBlocks;
+	}
+
+	tagBlock* GetBlock(unsigned long long qwHash) const
+	{
+		return &m_pBlocks[((qwHash >> 32) * m_dwBlockCount) >> 32];
+	}
+
+	static const unsigned int* GetSalt()
+	{
+		alignas(32) static const unsigned int s_dwSalt[BLOCK_WORDS] =
+		{
+			0x47B6137B, 0x44974D91, 0x8824AD5B, 0xA2B7289D,
+			0x705495C7, 0x2DF1424B, 0x9EFC4947, 0x5C6BFB31,
+		};
+		return s_dwSalt;
+	}
+
+#ifdef __AVX2__
+	static __m256i MakeMask(unsigned int dwHash)
+	{
+		__m256i vSalt = _mm256_load_si256((const __m256i*)GetSalt());
+		__m256i vBit = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(dwHash), vSalt), 27);
+		return _mm256_sllv_epi32(_mm256_set1_epi32(1), vBit);
+	}
+#endif
+
+	unsigned int		m_dwCapacity;
+	unsigned int		m_dwBlockCount;
+	tagBlock*			m_pBlocks;		// 뵽64ֽڣڱ
+};
+
+//-----------------------------------------------------------------------------
+inline XBloomFilter* XBloomFilter::Create(unsigned int dwCapacity)
+{
+	unsigned int dwBlocks = GetBlockCount(dwCapacity);
+	size_t nSize = sizeof(XBloomFilter) + 64 + (size_t)dwBlocks * sizeof(tagBlock);
+
+	XBloomFilter* pFilter = (XBloomFilter*)MCALLOC(nSize);
+	if (pFilter == nullptr)
+	{
+		return nullptr;
+	}
+
+	pFilter->m_dwCapacity = (unsigned int)((unsigned long long)dwBlocks * 256 / BITS_PER_KEY);	// ʵʷ
+	pFilter->m_dwBlockCount = dwBlocks;
+	pFilter->m_pBlocks = (tagBlock*)(((size_t)(pFilter + 1) + 63) & ~(size_t)63);
+	ZeroMemory(pFilter->m_pBlocks, (size_t)dwBlocks * sizeof(tagBlock));
+	return pFilter;
+}
+
+//-----------------------------------------------------------------------------
+inline XBloomFilter* XBloomFilter::Load(FILE* fp)
+{
+	unsigned int dwHead[2];
+	if (fread(dwHead, sizeof(dwHead), 1, fp) != 1 || GetBlockCount(dwHead[0]) != dwHead[1])
+	{
+		return nullptr;
+	}
+
+	XBloomFilter* pFilter = Create(dwHead[0]);
+	if (pFilter && fread(pFilter->m_pBlocks, sizeof(tagBlock), dwHead[1], fp) != dwHead[1])
+	{
+		Destroy(pFilter);
+		pFilter = nullptr;
+	}
+	return pFilter;
+}
+
+//-----------------------------------------------------------------------------
+inline bool XBloomFilter::Save(FILE* fp) const
+{
+	unsigned int dwHead[2] = { m_dwCapacity, m_dwBlockCount };
+	return fwrite(dwHead, sizeof(dwHead), 1, fp) == 1
+		&& fwrite(m_pBlocks, sizeof(tagBlock), m_dwBlockCount, fp) == m_dwBlockCount;
+}
+
+//-----------------------------------------------------------------------------
+inline void XBloomFilter::Add(unsigned long long qwKey)
+{
+	unsigned long long qwHash = Hash(qwKey);
+	tagBlock* pBlock = GetBlock(qwHash);
+
+#ifdef __AVX2__
+	__m256i* p = (__m256i*)pBlock;
+	_mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), MakeMask((unsigned int)qwHash)));
+#else
+	const unsigned int* pSalt = GetSalt();
+	for (int n = 0; n < BLOCK_WORDS; ++n)
+	{
+		pBlock->dwWord[n] |= 1u << (((unsigned int)qwHash * pSalt[n]) >> 27);
+	}
+#endif
+}
+
+//-----------------------------------------------------------------------------
+inline bool XBloomFilter::MayContain(unsigned long long qwKey) const
+{
+	unsigned long long qwHash = Hash(qwKey);
+	const tagBlock* pBlock = GetBlock(qwHash);
+
+#ifdef __AVX2__
+	return _mm256_testc_si256(_mm256_load_si256((const __m256i*)pBlock), MakeMask((unsigned int)qwHash)) != 0;
+#else
+	// ǰ˳չȽ
+	const unsigned int* pSalt = GetSalt();
+	unsigned int dwMiss = 0;
+	for (int n = 0; n < BLOCK_WORDS; ++n)
+	{
+		unsigned int dwBit = 1u << (((unsigned int)qwHash * pSalt[n]) >> 27);
+		dwMiss |= dwBit & ~pBlock->dwWord[n];
+	}
+	return dwMiss == 0;
+#endif
+}
+
+#endif // !__XBLOOMFILTER_H__
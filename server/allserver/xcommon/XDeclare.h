@@ -3,18 +3,165 @@
 #ifndef __XDECLARE_H__
 #define __XDECLARE_H__
 
-#include <winsock2.h>
-#include <mswsock.h>
-#include <windows.h>
-#include <mmsystem.h>
+#ifdef _WIN32
+#	include <winsock2.h>
+#	include <mswsock.h>
+#	include <windows.h>
+#	include <mmsystem.h>
+#	include <malloc.h>
+#else
+#	include <stdint.h>
+#	include <stdlib.h>
+#	include <string.h>
+#	include <unistd.h>
+#	include <pthread.h>
+#	include <sched.h>
+#endif
 #include <stdio.h>
 #include <string>
 #include <vector>
 #include <list>
 #include <map>
 
+#ifdef _WIN32
+
 #pragma comment( lib, "Ws2_32" )
 #pragma comment( lib, "Mswsock" )
 #pragma comment( lib, "winmm" )
 
+#else
+
+//-----------------------------------------------------------------------------
+// Windowsƽ̨ϲõWin32ͺͺȺWindowsһ
+//-----------------------------------------------------------------------------
+typedef int					BOOL;
+typedef unsigned char		BYTE;
+typedef unsigned short		WORD;
+typedef uint32_t			DWORD;
+typedef int32_t				LONG;
+typedef int64_t				LONGLONG;
+typedef char				CHAR;
+typedef BYTE*				LPBYTE;
+typedef LONG*				LPLONG;
+typedef void*				LPVOID;
+typedef uintptr_t			SOCKET;
+
+#ifndef TRUE
+#	define TRUE		1
+#	define FALSE	0
+#endif
+
+#define ZeroMemory(p, n)	memset((p), 0, (n))
+
+//-----------------------------------------------------------------------------
+// ԭӲWin32һȫ
+//-----------------------------------------------------------------------------
+inline LONG InterlockedIncrement(LONG volatile* p) { return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedDecrement(LONG volatile* p) { return __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedExchange(LONG volatile* p, LONG lValue) { return __atomic_exchange_n(p, lValue, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedExchangeAdd(LONG volatile* p, LONG lValue) { return __atomic_fetch_add(p, lValue, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedCompareExchange(LONG volatile* p, LONG lExchange, LONG lComparand)
+{
+	__atomic_compare_exchange_n(p, &lComparand, lExchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return lComparand;
+}
+
+inline LONGLONG InterlockedIncrement64(LONGLONG volatile* p) { return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST); }
+inline LONGLONG InterlockedDecrement64(LONGLONG volatile* p) { return __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST); }
+inline LONGLONG InterlockedExchange64(LONGLONG volatile* p, LONGLONG llValue) { return __atomic_exchange_n(p, llValue, __ATOMIC_SEQ_CST); }
+inline LONGLONG InterlockedExchangeAdd64(LONGLONG volatile* p, LONGLONG llValue) { return __atomic_fetch_add(p, llValue, __ATOMIC_SEQ_CST); }
+inline LONGLONG InterlockedCompareExchange64(LONGLONG volatile* p, LONGLONG llExchange, LONGLONG llComparand)
+{
+	__atomic_compare_exchange_n(p, &llComparand, llExchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return llComparand;
+}
+
+inline void* InterlockedExchangePointer(void* volatile* p, void* pValue) { return __atomic_exchange_n(p, pValue, __ATOMIC_SEQ_CST); }
+inline void* InterlockedCompareExchangePointer(void* volatile* p, void* pExchange, void* pComparand)
+{
+	__atomic_compare_exchange_n(p, &pComparand, pExchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return pComparand;
+}
+
+//-----------------------------------------------------------------------------
+inline void Sleep(DWORD dwMilliseconds)
+{
+	if (dwMilliseconds == 0)
+	{
+		sched_yield();
+	}
+	else
+	{
+		usleep((useconds_t)dwMilliseconds * 1000);
+	}
+}
+
+inline void DebugBreak()
+{
+	__builtin_trap();
+}
+
+//-----------------------------------------------------------------------------
+// ٽÿpthreadWindowsΪһ
+//-----------------------------------------------------------------------------
+struct CRITICAL_SECTION
+{
+	pthread_mutex_t		Mutex;
+};
+
+inline BOOL InitializeCriticalSectionAndSpinCount(CRITICAL_SECTION* pCS, DWORD)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	BOOL bOK = pthread_mutex_init(&pCS->Mutex, &attr) == 0;
+	pthread_mutexattr_destroy(&attr);
+	return bOK;
+}
+
+inline void DeleteCriticalSection(CRITICAL_SECTION* pCS) { pthread_mutex_destroy(&pCS->Mutex); }
+inline void EnterCriticalSection(CRITICAL_SECTION* pCS) { pthread_mutex_lock(&pCS->Mutex); }
+inline void LeaveCriticalSection(CRITICAL_SECTION* pCS) { pthread_mutex_unlock(&pCS->Mutex); }
+inline BOOL TryEnterCriticalSection(CRITICAL_SECTION* pCS) { return pthread_mutex_trylock(&pCS->Mutex) == 0; }
+
+#endif // _WIN32
+
+//-----------------------------------------------------------------------------
+// ȡСȡҪһ
+//-----------------------------------------------------------------------------
+template<typename T>
+inline T fxmin(T a, T b)
+{
+	return a < b ? a : b;
+}
+
+template<typename T>
+inline T fxmax(T a, T b)
+{
+	return a > b ? a : b;
+}
+
+//-----------------------------------------------------------------------------
+// nAlign䣬nAlignΪ2ݣʧܷnullptrֻXAlignedFreeͷ
+// alignas16ʵԼoperator newĶnew
+//-----------------------------------------------------------------------------
+inline void* XAlignedAlloc(size_t nSize, size_t nAlign)
+{
+#ifdef _WIN32
+	return _aligned_malloc(nSize, nAlign);
+#else
+	void* p = nullptr;
+	return posix_memalign(&p, nAlign < sizeof(void*) ? sizeof(void*) : nAlign, nSize) == 0 ? p : nullptr;
+#endif
+}
+
+inline void XAlignedFree(void* p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
 #endif // !__XDECLARE_H__
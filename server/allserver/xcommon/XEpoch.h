@@ -0,0 +1,423 @@
+#pragma once
+
+#ifndef __XEPOCH_H__
+#define __XEPOCH_H__
+
+#include "XMemCache.h"
+#include <new>
+#include <vector>
+
+extern XMemCache<XAtomMutex>*	g_pMemCache;
+
+//-----------------------------------------------------------------------------
+// ṹӳٻ
+//
+// XEpochGuardסԹṹķʣڼ俴Ľڵ㲻ᱻͷ
+// д߰ѽڵժRetireڵȹڱ̵߳бϣ
+// ȫּԪǰκڶ̶߳뿪ժǰļԪܳһFreeBatch黹ڴ
+//
+// úܾõ̻߳ῨסԪǰΣָ룺
+// ԪProtectõĽڵ㣬ʱĽڵ
+//
+// ˳߳ûĽڵһReclaim֣û߳RetireʱҪ˶ڵFlush
+//
+// ֻܻMCALLOCڴ
+//-----------------------------------------------------------------------------
+class XEpoch
+{
+public:
+	enum
+	{
+		HAZARD_SLOTS	= 4,	// ÿ߳Σָ
+		RETIRE_BATCH	= 64,	// ܹôųԻ
+	};
+
+	//-----------------------------------------------------------------------------
+	// 뿪Ƕ
+	//-----------------------------------------------------------------------------
+	static void Enter()
+	{
+		tagThread* pThread = GetThread();
+		if (pThread->nNest++ == 0)
+		{
+			LONGLONG llEpoch = ::InterlockedCompareExchange64(&GetGlobalEpoch(), 0, 0);
+			::InterlockedExchange64(&pThread->llState, (llEpoch << 1) | 1);
+		}
+	}
+
+	static void Leave()
+	{
+		tagThread* pThread = GetThread();
+		if (--pThread->nNest == 0)
+		{
+			::InterlockedExchange64(&pThread->llState, pThread->llState & ~1LL);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	// ѾժĽڵ㣬ú̲߳ٷ
+	//-----------------------------------------------------------------------------
+	static void Retire(void* pMem)
+	{
+		tagThread* pThread = GetThread();
+		tagRetired retired;
+		retired.pMem = pMem;
+		retired.llEpoch = ::InterlockedCompareExchange64(&GetGlobalEpoch(), 0, 0);
+		pThread->Retired.push_back(retired);
+
+		if ((int)pThread->Retired.size() >= pThread->nThreshold)
+		{
+			Reclaim(pThread);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	// Σָ룺*ppSrcŽnSlotŲۣʱڵܱΪգ
+	//-----------------------------------------------------------------------------
+	static void* Protect(int nSlot, void* volatile* ppSrc)
+	{
+		tagThread* pThread = GetThread();
+		void* p = *ppSrc;
+		for (;;)
+		{
+			::InterlockedExchangePointer(&pThread->pHazard[nSlot], p);
+			void* pNow = *ppSrc;
+			if (pNow == p)
+			{
+				return p;
+			}
+			p = pNow;
+		}
+	}
+
+	static void Release(int nSlot)
+	{
+		GetThread()->pHazard[nSlot] = nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ձ̹߳ŵĺ˳߳µĽڵ㣬ع黹ĸ
+	// ûжʱμԪ֮ǰժĶܻ
+	//-----------------------------------------------------------------------------
+	static int Flush()
+	{
+		TryAdvance();
+		return Reclaim(GetThread());
+	}
+
+	//-----------------------------------------------------------------------------
+	static unsigned long long GetEpoch()
+	{
+		return (unsigned long long)::InterlockedCompareExchange64(&GetGlobalEpoch(), 0, 0);
+	}
+
+private:
+	struct tagRetired
+	{
+		void*		pMem;
+		LONGLONG	llEpoch;	// ժʱȫּԪ
+	};
+
+	//-----------------------------------------------------------------------------
+	// ÿ߳һ߳˳̸߳ãͷ
+	// ״̬ռһУ߳ɨʱͱ߳
+	//-----------------------------------------------------------------------------
+	struct alignas(64) tagThread
+	{
+		LONGLONG volatile		llState;				// Ԫ << 1 | Ƿڶ
+		char					Pad1[64 - sizeof(LONGLONG)];
+		void* volatile			pHazard[HAZARD_SLOTS];
+		LONG volatile			lInUse;
+		int						nNest;
+		int						nThreshold;				// ŵĸŻ
+		std::vector<tagRetired>	Retired;				// ̷ֻ߳
+		tagThread*				pNext;
+
+		// ͨnew֤64ֽڶ
+		static void* operator new(size_t nSize)
+		{
+			void* p = XAlignedAlloc(nSize, alignof(tagThread));
+			if (p == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+			return p;
+		}
+
+		static void operator delete(void* p)
+		{
+			XAlignedFree(p);
+		}
+	};
+
+	//-----------------------------------------------------------------------------
+	// ߳˳ʱûյĽڵ㽻߳
+	//-----------------------------------------------------------------------------
+	struct tagHolder
+	{
+		tagThread*	pThread;
+
+		tagHolder() : pThread(nullptr)
+		{
+		}
+
+		~tagHolder()
+		{
+			if (pThread)
+			{
+				ReleaseThread(pThread);
+			}
+		}
+	};
+
+	//-----------------------------------------------------------------------------
+	static LONGLONG volatile& GetGlobalEpoch()
+	{
+		static LONGLONG volatile s_llEpoch = 0;
+		return s_llEpoch;
+	}
+
+	static XMutex& GetLock()
+	{
+		static XMutex s_Lock;
+		return s_Lock;
+	}
+
+	static tagThread* volatile& GetThreadList()
+	{
+		static tagThread* volatile s_pList = nullptr;
+		return s_pList;
+	}
+
+	// ˳߳µĽڵ㣬
+	static std::vector<tagRetired>& GetOrphans()
+	{
+		static std::vector<tagRetired> s_Orphans;
+		return s_Orphans;
+	}
+
+	// ¶ʱ£ֻжҪҪȥ
+	static LONG volatile& GetOrphanCount()
+	{
+		static LONG volatile s_lCount = 0;
+		return s_lCount;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ǰ̵߳ļ¼һʹʱȡһеĻ½
+	//-----------------------------------------------------------------------------
+	static tagThread* GetThread()
+	{
+		static thread_local tagHolder s_Holder;
+		if (!s_Holder.pThread)
+		{
+			s_Holder.pThread = AcquireThread();
+		}
+		return s_Holder.pThread;
+	}
+
+	static tagThread* AcquireThread();
+	static void ReleaseThread(tagThread* pThread);
+	static bool TryAdvance();
+	static int Reclaim(tagThread* pThread);
+};
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+class XEpochGuard
+{
+public:
+	XEpochGuard()
+	{
+		XEpoch::Enter();
+	}
+
+	~XEpochGuard()
+	{
+		XEpoch::Leave();
+	}
+
+private:
+	XEpochGuard(const XEpochGuard&) = delete;
+	XEpochGuard& operator=(const XEpochGuard&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+// Σָ뿪ʱ
+//-----------------------------------------------------------------------------
+template<typename T>
+class XHazardPtr
+{
+public:
+	explicit XHazardPtr(int nSlot) : m_nSlot(nSlot)
+	{
+	}
+
+	~XHazardPtr()
+	{
+		XEpoch::Release(m_nSlot);
+	}
+
+	T* Protect(T* volatile* ppSrc)
+	{
+		return (T*)XEpoch::Protect(m_nSlot, (void* volatile*)ppSrc);
+	}
+
+private:
+	XHazardPtr(const XHazardPtr&) = delete;
+	XHazardPtr& operator=(const XHazardPtr&) = delete;
+
+	int		m_nSlot;
+};
+
+//-----------------------------------------------------------------------------
+// ȡһм¼ûо½ҵͷֻɨʱü
+//-----------------------------------------------------------------------------
+inline XEpoch::tagThread* XEpoch::AcquireThread()
+{
+	for (tagThread* p = GetThreadList(); p; p = p->pNext)
+	{
+		if (p->lInUse == 0 && ::InterlockedCompareExchange(&p->lInUse, 1, 0) == 0)
+		{
+			return p;
+		}
+	}
+
+	tagThread* pThread = new tagThread;
+	pThread->llState = 0;
+	ZeroMemory((void*)pThread->pHazard, sizeof(pThread->pHazard));
+	pThread->lInUse = 1;
+	pThread->nNest = 0;
+	pThread->nThreshold = RETIRE_BATCH;
+
+	GetLock().Lock();
+	pThread->pNext = GetThreadList();
+	::InterlockedExchangePointer((void* volatile*)&GetThreadList(), pThread);
+	GetLock().Unlock();
+	return pThread;
+}
+
+//-----------------------------------------------------------------------------
+// ߳˳Ⱦգ֮ͬǰĹ¶ʣµķŽб
+//-----------------------------------------------------------------------------
+inline void XEpoch::ReleaseThread(tagThread* pThread)
+{
+	TryAdvance();
+	Reclaim(pThread);
+
+	if (!pThread->Retired.empty())
+	{
+		GetLock().Lock();
+		std::vector<tagRetired>& orphans = GetOrphans();
+		orphans.insert(orphans.end(), pThread->Retired.begin(), pThread->Retired.end());
+		::InterlockedExchange(&GetOrphanCount(), (LONG)orphans.size());
+		GetLock().Unlock();
+		pThread->Retired.clear();
+	}
+
+	ZeroMemory((void*)pThread->pHazard, sizeof(pThread->pHazard));
+	pThread->nNest = 0;
+	pThread->nThreshold = RETIRE_BATCH;
+	::InterlockedExchange64(&pThread->llState, 0);
+	::InterlockedExchange(&pThread->lInUse, 0);
+}
+
+//-----------------------------------------------------------------------------
+// ڶ̶߳˵ǰԪǰһ
+//-----------------------------------------------------------------------------
+inline bool XEpoch::TryAdvance()
+{
+	LONGLONG llEpoch = ::InterlockedCompareExchange64(&GetGlobalEpoch(), 0, 0);
+	for (tagThread* p = GetThreadList(); p; p = p->pNext)
+	{
+		LONGLONG llState = ::InterlockedCompareExchange64(&p->llState, 0, 0);
+		if ((llState & 1) && (llState >> 1) != llEpoch)
+		{
+			return false;
+		}
+	}
+	return ::InterlockedCompareExchange64(&GetGlobalEpoch(), llEpoch + 1, llEpoch) == llEpoch;
+}
+
+//-----------------------------------------------------------------------------
+// ժʱԪΪeĽڵ㣬ȫּԪe+2ʱûжܿ
+// ųΣָ뱣ģʣµһ黹
+//-----------------------------------------------------------------------------
+inline int XEpoch::Reclaim(tagThread* pThread)
+{
+	std::vector<tagRetired>& retired = pThread->Retired;
+
+	// ˳˳߳µ
+	if (::InterlockedCompareExchange(&GetOrphanCount(), 0, 0) != 0)
+	{
+		GetLock().Lock();
+		std::vector<tagRetired>& orphans = GetOrphans();
+		retired.insert(retired.end(), orphans.begin(), orphans.end());
+		orphans.clear();
+		::InterlockedExchange(&GetOrphanCount(), 0);
+		GetLock().Unlock();
+	}
+
+	TryAdvance();
+	LONGLONG llSafe = ::InterlockedCompareExchange64(&GetGlobalEpoch(), 0, 0) - 2;
+
+	// ռΣָ룬ʱһû
+	void* pHazards[64];
+	int nHazards = 0;
+	for (tagThread* p = GetThreadList(); p; p = p->pNext)
+	{
+		for (int n = 0; n < HAZARD_SLOTS; ++n)
+		{
+			void* pHazard = p->pHazard[n];
+			if (pHazard && nHazards < (int)(sizeof(pHazards) / sizeof(pHazards[0])))
+			{
+				pHazards[nHazards++] = pHazard;
+			}
+			else if (pHazard)
+			{
+				llSafe = -1;	// Ų¾ȫ
+			}
+		}
+	}
+
+	void* pBatch[RETIRE_BATCH];
+	int nBatch = 0;
+	int nFreed = 0;
+	size_t nKeep = 0;
+	for (size_t n = 0; n < retired.size(); ++n)
+	{
+		bool bSafe = retired[n].llEpoch <= llSafe;
+		for (int h = 0; bSafe && h < nHazards; ++h)
+		{
+			bSafe = (pHazards[h] != retired[n].pMem);
+		}
+
+		if (!bSafe)
+		{
+			retired[nKeep++] = retired[n];
+			continue;
+		}
+
+		pBatch[nBatch++] = retired[n].pMem;
+		if (nBatch == RETIRE_BATCH)
+		{
+			MCFREEBATCH(pBatch, nBatch);
+			nFreed += nBatch;
+			nBatch = 0;
+		}
+	}
+
+	if (nBatch > 0)
+	{
+		MCFREEBATCH(pBatch, nBatch);
+		nFreed += nBatch;
+	}
+	retired.resize(nKeep);
+
+	// жһֱʱʣµĻԽԽֵ࣬ǣÿRetireɨһ
+	pThread->nThreshold = nKeep * 2 > RETIRE_BATCH ? (int)nKeep * 2 : RETIRE_BATCH;
+	return nFreed;
+}
+
+#endif // !__XEPOCH_H__
@@ -0,0 +1,290 @@
+#pragma once
+
+#ifndef __XHISTOGRAM_H__
+#define __XHISTOGRAM_H__
+
+#include "XMutex.h"
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// HDRӳֱͼ3λЧ֣¼Χ12^42
+// 2ݷͰÿͰԷ1024ǧ֮һ
+// RecordԶ߳ͬʱ
+// ʽHdrHistogrampercentile distributionֱͬùٷĹ߻ͼ
+//-----------------------------------------------------------------------------
+class XHistogram
+{
+public:
+	enum
+	{
+		SUB_BUCKET_BITS		= 11,							// ÿͰ2048ǰһһͰص
+		SUB_BUCKET_COUNT	= 1 << SUB_BUCKET_BITS,
+		SUB_BUCKET_HALF		= SUB_BUCKET_COUNT / 2,
+		BUCKET_COUNT		= 32,
+		COUNTS_LEN			= (BUCKET_COUNT + 1) * SUB_BUCKET_HALF,
+	};
+
+	//-----------------------------------------------------------------------------
+	// ¼һֵΧİֵ
+	//-----------------------------------------------------------------------------
+	void Record(unsigned long long qwValue)
+	{
+		::InterlockedIncrement64((LONGLONG volatile*)&m_qwCounts[GetIndex(qwValue)]);
+		::InterlockedIncrement64((LONGLONG volatile*)&m_qwTotal);
+	}
+
+	//-----------------------------------------------------------------------------
+	// ϲһֱͼ
+	//-----------------------------------------------------------------------------
+	void Add(const XHistogram& other)
+	{
+		for (int n = 0; n < COUNTS_LEN; ++n)
+		{
+			if (other.m_qwCounts[n])
+			{
+				::InterlockedExchangeAdd64((LONGLONG volatile*)&m_qwCounts[n], other.m_qwCounts[n]);
+			}
+		}
+		::InterlockedExchangeAdd64((LONGLONG volatile*)&m_qwTotal, other.m_qwTotal);
+	}
+
+	void Reset()
+	{
+		ZeroMemory((void*)m_qwCounts, sizeof(m_qwCounts));
+		m_qwTotal = 0;
+	}
+
+	unsigned long long GetTotalCount() const { return m_qwTotal; }
+
+	//-----------------------------------------------------------------------------
+	// ٷλϵֵdPercentileΪ0100
+	//-----------------------------------------------------------------------------
+	unsigned long long GetValueAtPercentile(double dPercentile) const;
+
+	unsigned long long GetMax() const;
+	unsigned long long GetMin() const;
+	double GetMean() const;
+	double GetStdDeviation() const;
+
+	//-----------------------------------------------------------------------------
+	// ٷλֲdScaleΪʱֵҪı¼΢롢1000
+	//-----------------------------------------------------------------------------
+	void OutputPercentiles(FILE* fp, double dScale, int nTicksPerHalf = 5) const;
+
+	//-----------------------------------------------------------------------------
+	XHistogram()
+	{
+		Reset();
+	}
+
+private:
+	//-----------------------------------------------------------------------------
+	// ֵڵĸ
+	//-----------------------------------------------------------------------------
+	static int GetIndex(unsigned long long qwValue)
+	{
+		int nBucket = HighBit(qwValue | (SUB_BUCKET_COUNT - 1)) - (SUB_BUCKET_BITS - 1);
+		if (nBucket >= BUCKET_COUNT)
+		{
+			return COUNTS_LEN - 1;
+		}
+
+		int nSub = (int)(qwValue >> nBucket);
+		return ((nBucket + 1) << (SUB_BUCKET_BITS - 1)) + (nSub - SUB_BUCKET_HALF);
+	}
+
+	//-----------------------------------------------------------------------------
+	// Сֵ͸Ŀ
+	//-----------------------------------------------------------------------------
+	static unsigned long long GetValue(int nIndex, unsigned long long& qwWidth)
+	{
+		int nBucket = (nIndex >> (SUB_BUCKET_BITS - 1)) - 1;
+		int nSub = (nIndex & (SUB_BUCKET_HALF - 1)) + SUB_BUCKET_HALF;
+		if (nBucket < 0)
+		{
+			nSub -= SUB_BUCKET_HALF;
+			nBucket = 0;
+		}
+		qwWidth = 1ULL << nBucket;
+		return (unsigned long long)nSub << nBucket;
+	}
+
+	//-----------------------------------------------------------------------------
+	// λλ
+	//-----------------------------------------------------------------------------
+	static int HighBit(unsigned long long qwValue)
+	{
+		int nBit = 0;
+		while (qwValue >>= 1)
+		{
+			++nBit;
+		}
+		return nBit;
+	}
+
+	unsigned long long volatile	m_qwCounts[COUNTS_LEN];
+	unsigned long long volatile	m_qwTotal;
+};
+
+//-----------------------------------------------------------------------------
+// ٷλϵֵȡڸֵ
+//-----------------------------------------------------------------------------
+inline unsigned long long XHistogram::GetValueAtPercentile(double dPercentile) const
+{
+	if (m_qwTotal == 0)
+	{
+		return 0;
+	}
+
+	if (dPercentile > 100.0)
+	{
+		dPercentile = 100.0;
+	}
+
+	unsigned long long qwTarget = (unsigned long long)ceil(dPercentile / 100.0 * m_qwTotal);
+	if (qwTarget == 0)
+	{
+		qwTarget = 1;
+	}
+
+	unsigned long long qwSum = 0;
+	for (int n = 0; n < COUNTS_LEN; ++n)
+	{
+		qwSum += m_qwCounts[n];
+		if (qwSum >= qwTarget)
+		{
+			unsigned long long qwWidth;
+			unsigned long long qwValue = GetValue(n, qwWidth);
+			return qwValue + qwWidth - 1;
+		}
+	}
+	return GetMax();
+}
+
+//-----------------------------------------------------------------------------
+inline unsigned long long XHistogram::GetMax() const
+{
+	for (int n = COUNTS_LEN - 1; n >= 0; --n)
+	{
+		if (m_qwCounts[n])
+		{
+			unsigned long long qwWidth;
+			unsigned long long qwValue = GetValue(n, qwWidth);
+			return qwValue + qwWidth - 1;
+		}
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+inline unsigned long long XHistogram::GetMin() const
+{
+	for (int n = 0; n < COUNTS_LEN; ++n)
+	{
+		if (m_qwCounts[n])
+		{
+			unsigned long long qwWidth;
+			return GetValue(n, qwWidth);
+		}
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// ֵÿȡмֵ
+//-----------------------------------------------------------------------------
+inline double XHistogram::GetMean() const
+{
+	if (m_qwTotal == 0)
+	{
+		return 0.0;
+	}
+
+	double dSum = 0.0;
+	for (int n = 0; n < COUNTS_LEN; ++n)
+	{
+		if (m_qwCounts[n])
+		{
+			unsigned long long qwWidth;
+			unsigned long long qwValue = GetValue(n, qwWidth);
+			dSum += (qwValue + qwWidth / 2.0) * m_qwCounts[n];
+		}
+	}
+	return dSum / m_qwTotal;
+}
+
+//-----------------------------------------------------------------------------
+inline double XHistogram::GetStdDeviation() const
+{
+	if (m_qwTotal == 0)
+	{
+		return 0.0;
+	}
+
+	double dMean = GetMean();
+	double dSum = 0.0;
+	for (int n = 0; n < COUNTS_LEN; ++n)
+	{
+		if (m_qwCounts[n])
+		{
+			unsigned long long qwWidth;
+			double dDev = GetValue(n, qwWidth) + qwWidth / 2.0 - dMean;
+			dSum += dDev * dDev * m_qwCounts[n];
+		}
+	}
+	return sqrt(dSum / m_qwTotal);
+}
+
+//-----------------------------------------------------------------------------
+// ٷλԽӽ100̶ԽܣÿһʣnTicksPerHalf
+//-----------------------------------------------------------------------------
+inline void XHistogram::OutputPercentiles(FILE* fp, double dScale, int nTicksPerHalf) const
+{
+	fprintf(fp, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+	if (m_qwTotal > 0)
+	{
+		unsigned long long qwSum = 0;
+		double dNext = 0.0;
+		for (int n = 0; n < COUNTS_LEN; ++n)
+		{
+			if (m_qwCounts[n] == 0)
+			{
+				continue;
+			}
+
+			qwSum += m_qwCounts[n];
+			unsigned long long qwWidth;
+			double dValue = (GetValue(n, qwWidth) + qwWidth - 1) / dScale;
+			double dPercentile = 100.0 * qwSum / m_qwTotal;
+
+			// һ̶ܿȣֻһ
+			if (dPercentile < dNext && qwSum < m_qwTotal)
+			{
+				continue;
+			}
+
+			if (qwSum < m_qwTotal)
+			{
+				fprintf(fp, "%12.3f %2.12f %10llu %14.2f\n", dValue, dPercentile / 100.0, qwSum, 1.0 / (1.0 - dPercentile / 100.0));
+			}
+			else
+			{
+				fprintf(fp, "%12.3f %2.12f %10llu\n", dValue, 1.0, qwSum);
+				break;
+			}
+
+			while (dNext <= dPercentile)
+			{
+				double dHalf = pow(2.0, floor(log2(100.0 / (100.0 - dNext))) + 1);
+				dNext += 100.0 / (nTicksPerHalf * dHalf);
+			}
+		}
+	}
+
+	fprintf(fp, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", GetMean() / dScale, GetStdDeviation() / dScale);
+	fprintf(fp, "#[Max     = %12.3f, Total count    = %12llu]\n", GetMax() / dScale, m_qwTotal);
+	fprintf(fp, "#[Buckets = %12d, SubBuckets     = %12d]\n", BUCKET_COUNT, SUB_BUCKET_COUNT);
+}
+
+#endif // !__XHISTOGRAM_H__
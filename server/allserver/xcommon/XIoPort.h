@@ -0,0 +1,674 @@
+#pragma once
+
+#ifndef __XIOPORT_H__
+#define __XIOPORT_H__
+
+#include "XTask.h"
+
+#if XCORO_SUPPORTED
+
+#ifndef _WIN32
+#	include <sys/epoll.h>
+#	include <sys/eventfd.h>
+#	include <sys/socket.h>
+#	include <errno.h>
+#	include <unistd.h>
+#	include <unordered_map>
+#endif
+
+//-----------------------------------------------------------------------------
+// Э̵ȺIO
+// Windowsɶ˿ڣƽ̨epoll
+// ߳̿ͬʱRunЭĸָ̻߳ȷ
+//-----------------------------------------------------------------------------
+class XIoPort
+{
+public:
+	//-----------------------------------------------------------------------------
+	// һڵȴЭ֡
+	//-----------------------------------------------------------------------------
+#ifdef _WIN32
+	struct tagIoOp : OVERLAPPED
+#else
+	struct tagIoOp
+#endif
+	{
+		XCoroHandle		h;
+		SOCKET			s;
+		void*			pBuf;
+		DWORD			dwLen;
+		bool			bWrite;
+		int				nResult;	// ֽΪ-1
+	};
+
+	//-----------------------------------------------------------------------------
+	// շĵȴ壬ΪֽԷرΪ0Ϊ-1
+	//-----------------------------------------------------------------------------
+	class XIoAwaiter
+	{
+	public:
+		XIoAwaiter(XIoPort* pPort, SOCKET s, void* pBuf, DWORD dwLen, bool bWrite)
+			: m_pPort(pPort)
+			, m_Op()	// ֵʼOVERLAPPED
+		{
+			m_Op.s = s;
+			m_Op.pBuf = pBuf;
+			m_Op.dwLen = dwLen;
+			m_Op.bWrite = bWrite;
+		}
+
+		bool await_ready() { return m_pPort->TryComplete(&m_Op); }
+		bool await_suspend(XCoroHandle h) { m_Op.h = h; return m_pPort->Submit(&m_Op); }
+		int await_resume() { return m_Op.nResult; }
+
+	private:
+		XIoPort*	m_pPort;
+		tagIoOp		m_Op;
+	};
+
+	//-----------------------------------------------------------------------------
+	// еIOִ̼߳
+	//-----------------------------------------------------------------------------
+	class XScheduleAwaiter
+	{
+	public:
+		explicit XScheduleAwaiter(XIoPort* pPort) : m_pPort(pPort) {}
+
+		bool await_ready() { return false; }
+		void await_suspend(XCoroHandle h) { m_pPort->Post(h); }
+		void await_resume() {}
+
+	private:
+		XIoPort*	m_pPort;
+	};
+
+	//-----------------------------------------------------------------------------
+	// ʧܷfalse
+	//-----------------------------------------------------------------------------
+	bool Create();
+
+	//-----------------------------------------------------------------------------
+	// ֪ͨRun
+	//-----------------------------------------------------------------------------
+	void Stop();
+
+	//-----------------------------------------------------------------------------
+	// շǰȹsocketرǰȡʱܻδɵշ
+	//-----------------------------------------------------------------------------
+	bool Attach(SOCKET s);
+	void Detach(SOCKET s);
+
+	//-----------------------------------------------------------------------------
+	// IO߳лָЭ̣κ̶߳Ե
+	//-----------------------------------------------------------------------------
+	void Post(XCoroHandle h);
+
+	//-----------------------------------------------------------------------------
+	// ¼ͻָЭֱ̣Stop
+	//-----------------------------------------------------------------------------
+	void Run();
+
+	//-----------------------------------------------------------------------------
+	XIoAwaiter Recv(SOCKET s, void* pBuf, DWORD dwLen) { return XIoAwaiter(this, s, pBuf, dwLen, false); }
+	XIoAwaiter Send(SOCKET s, const void* pBuf, DWORD dwLen) { return XIoAwaiter(this, s, (void*)pBuf, dwLen, true); }
+	XScheduleAwaiter Schedule() { return XScheduleAwaiter(this); }
+
+	//-----------------------------------------------------------------------------
+	// dwLenֽڣɹtrue
+	//-----------------------------------------------------------------------------
+	XTask<bool> RecvAll(SOCKET s, void* pBuf, DWORD dwLen);
+	XTask<bool> SendAll(SOCKET s, const void* pBuf, DWORD dwLen);
+
+	//-----------------------------------------------------------------------------
+	XIoPort();
+	~XIoPort();
+
+private:
+	//-----------------------------------------------------------------------------
+	// ɵֱɣ
+	//-----------------------------------------------------------------------------
+	bool TryComplete(tagIoOp* pOp);
+
+	//-----------------------------------------------------------------------------
+	// ύfalseʱ𣬽nResult
+	//-----------------------------------------------------------------------------
+	bool Submit(tagIoOp* pOp);
+
+#ifdef _WIN32
+	enum
+	{
+		KEY_IO,			// 
+		KEY_RESUME,		// PostЭ
+		KEY_STOP,
+	};
+
+	HANDLE						m_hPort;
+#else
+	//-----------------------------------------------------------------------------
+	// һsocketպͷͬʱ𣬸ǸģǼǵĹע¼ߵĲ
+	//-----------------------------------------------------------------------------
+	struct tagIoSocket
+	{
+		XAtomMutex		Lock;
+		SOCKET			s;
+		tagIoOp*		pRead;
+		tagIoOp*		pWrite;
+	};
+
+	//-----------------------------------------------------------------------------
+	// ҵsocketûзnullptr
+	//-----------------------------------------------------------------------------
+	tagIoSocket* LockSocket(SOCKET s);
+
+	//-----------------------------------------------------------------------------
+	// ڵȴĲµǼǣEPOLLONESHOTҪµǼǣҪsocket
+	//-----------------------------------------------------------------------------
+	bool Arm(tagIoSocket* pSocket);
+
+	//-----------------------------------------------------------------------------
+	// ȡ¼ӦĲʣµµǼǣȡĸ
+	//-----------------------------------------------------------------------------
+	int TakeReady(SOCKET s, unsigned int dwEvents, tagIoOp* pReady[2]);
+
+	int							m_nEpoll;
+	int							m_nEvent;		// PostStopʱ
+	XAtomMutex					m_PostLock;
+	std::vector<XCoroHandle>	m_Posted;
+	XAtomMutex					m_SocketLock;	// ȼټtagIoSocket::Lock
+	std::unordered_map<SOCKET, tagIoSocket*>	m_Sockets;
+#endif
+	bool volatile				m_bStop;
+};
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+inline XTask<bool> XIoPort::RecvAll(SOCKET s, void* pBuf, DWORD dwLen)
+{
+	DWORD dwDone = 0;
+	while (dwDone < dwLen)
+	{
+		int nRet = co_await Recv(s, (char*)pBuf + dwDone, dwLen - dwDone);
+		if (nRet <= 0)
+		{
+			co_return false;
+		}
+		dwDone += nRet;
+	}
+	co_return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+inline XTask<bool> XIoPort::SendAll(SOCKET s, const void* pBuf, DWORD dwLen)
+{
+	DWORD dwDone = 0;
+	while (dwDone < dwLen)
+	{
+		int nRet = co_await Send(s, (const char*)pBuf + dwDone, dwLen - dwDone);
+		if (nRet <= 0)
+		{
+			co_return false;
+		}
+		dwDone += nRet;
+	}
+	co_return true;
+}
+
+#ifdef _WIN32
+
+//-----------------------------------------------------------------------------
+inline XIoPort::XIoPort()
+	: m_hPort(NULL)
+	, m_bStop(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+inline XIoPort::~XIoPort()
+{
+	if (m_hPort)
+	{
+		::CloseHandle(m_hPort);
+	}
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Create()
+{
+	m_hPort = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+	return m_hPort != NULL;
+}
+
+//-----------------------------------------------------------------------------
+inline void XIoPort::Stop()
+{
+	m_bStop = true;
+	::PostQueuedCompletionStatus(m_hPort, 0, KEY_STOP, NULL);
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Attach(SOCKET s)
+{
+	return ::CreateIoCompletionPort((HANDLE)s, m_hPort, KEY_IO, 0) != NULL;
+}
+
+//-----------------------------------------------------------------------------
+// رsocketʱɶ˿Լ
+//-----------------------------------------------------------------------------
+inline void XIoPort::Detach(SOCKET s)
+{
+}
+
+//-----------------------------------------------------------------------------
+inline void XIoPort::Post(XCoroHandle h)
+{
+	::PostQueuedCompletionStatus(m_hPort, 0, KEY_RESUME, (LPOVERLAPPED)h.address());
+}
+
+//-----------------------------------------------------------------------------
+inline void XIoPort::Run()
+{
+	while (!m_bStop)
+	{
+		DWORD dwBytes = 0;
+		ULONG_PTR ulKey = 0;
+		LPOVERLAPPED pOverlapped = NULL;
+		BOOL bOK = ::GetQueuedCompletionStatus(m_hPort, &dwBytes, &ulKey, &pOverlapped, INFINITE);
+
+		if (ulKey == KEY_STOP)
+		{
+			::PostQueuedCompletionStatus(m_hPort, 0, KEY_STOP, NULL);	// һ߳
+			break;
+		}
+
+		if (ulKey == KEY_RESUME)
+		{
+			XCoroHandle::from_address(pOverlapped).resume();
+			continue;
+		}
+
+		if (pOverlapped == NULL)
+		{
+			continue;	// ɶ˿ڱ
+		}
+
+		tagIoOp* pOp = (tagIoOp*)pOverlapped;
+		pOp->nResult = bOK ? (int)dwBytes : -1;
+		pOp->h.resume();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ɶ˿ܻͶݽ
+//-----------------------------------------------------------------------------
+inline bool XIoPort::TryComplete(tagIoOp* pOp)
+{
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Submit(tagIoOp* pOp)
+{
+	WSABUF wsaBuf;
+	wsaBuf.buf = (char*)pOp->pBuf;
+	wsaBuf.len = pOp->dwLen;
+	DWORD dwFlags = 0;
+
+	int nRet = pOp->bWrite
+		? ::WSASend(pOp->s, &wsaBuf, 1, NULL, 0, pOp, NULL)
+		: ::WSARecv(pOp->s, &wsaBuf, 1, NULL, &dwFlags, pOp, NULL);
+
+	// ɹ𶼻յ֪֮ͨpOpѱָ̻߳ٷ
+	if (nRet == SOCKET_ERROR && ::WSAGetLastError() != WSA_IO_PENDING)
+	{
+		pOp->nResult = -1;
+		return false;
+	}
+	return true;
+}
+
+#else
+
+//-----------------------------------------------------------------------------
+inline XIoPort::XIoPort()
+	: m_nEpoll(-1)
+	, m_nEvent(-1)
+	, m_bStop(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+inline XIoPort::~XIoPort()
+{
+	for (auto it = m_Sockets.begin(); it != m_Sockets.end(); ++it)
+	{
+		delete it->second;
+	}
+
+	if (m_nEvent >= 0)
+	{
+		close(m_nEvent);
+	}
+	if (m_nEpoll >= 0)
+	{
+		close(m_nEpoll);
+	}
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Create()
+{
+	m_nEpoll = epoll_create1(EPOLL_CLOEXEC);
+	m_nEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_nEpoll < 0 || m_nEvent < 0)
+	{
+		return false;
+	}
+
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u64 = 0;
+	ev.data.fd = m_nEvent;
+	return epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, m_nEvent, &ev) == 0;
+}
+
+//-----------------------------------------------------------------------------
+inline void XIoPort::Stop()
+{
+	m_bStop = true;
+	unsigned long long qwOne = 1;
+	(void)write(m_nEvent, &qwOne, sizeof(qwOne));
+}
+
+//-----------------------------------------------------------------------------
+// Ȳעκ¼ʱٵǼ
+// EPOLLONESHOTʱԷϿEPOLLHUPҲֻһ
+// ¼socketָ룬ʱȡ󵽴ľ¼鲻Ͷ
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Attach(SOCKET s)
+{
+	tagIoSocket* pSocket = new tagIoSocket;
+	pSocket->s = s;
+	pSocket->pRead = nullptr;
+	pSocket->pWrite = nullptr;
+
+	epoll_event ev;
+	ev.events = EPOLLONESHOT;
+	ev.data.u64 = 0;
+	ev.data.fd = (int)s;
+	if (epoll_ctl(m_nEpoll, EPOLL_CTL_ADD, (int)s, &ev) != 0)
+	{
+		delete pSocket;
+		return false;
+	}
+
+	m_SocketLock.Lock();
+	tagIoSocket*& pSlot = m_Sockets[s];
+	tagIoSocket* pOld = pSlot;	// һͬsocketȡ
+	pSlot = pSocket;
+	m_SocketLock.Unlock();
+
+	delete pOld;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// ӱժٵһsocketڴ̷ֺ߳ͷ
+//-----------------------------------------------------------------------------
+inline void XIoPort::Detach(SOCKET s)
+{
+	m_SocketLock.Lock();
+	auto it = m_Sockets.find(s);
+	if (it == m_Sockets.end())
+	{
+		m_SocketLock.Unlock();
+		return;
+	}
+	tagIoSocket* pSocket = it->second;
+	m_Sockets.erase(it);
+	m_SocketLock.Unlock();
+
+	epoll_ctl(m_nEpoll, EPOLL_CTL_DEL, (int)s, nullptr);
+
+	pSocket->Lock.Lock();
+	pSocket->Lock.Unlock();
+	delete pSocket;
+}
+
+//-----------------------------------------------------------------------------
+inline XIoPort::tagIoSocket* XIoPort::LockSocket(SOCKET s)
+{
+	m_SocketLock.Lock();
+	auto it = m_Sockets.find(s);
+	tagIoSocket* pSocket = it != m_Sockets.end() ? it->second : nullptr;
+	if (pSocket)
+	{
+		pSocket->Lock.Lock();
+	}
+	m_SocketLock.Unlock();
+	return pSocket;
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Arm(tagIoSocket* pSocket)
+{
+	if (pSocket->pRead == nullptr && pSocket->pWrite == nullptr)
+	{
+		return true;	// ֹرգ´Submit
+	}
+
+	epoll_event ev;
+	ev.events = EPOLLONESHOT | (pSocket->pRead ? (unsigned int)EPOLLIN : 0u) | (pSocket->pWrite ? (unsigned int)EPOLLOUT : 0u);
+	ev.data.u64 = 0;
+	ev.data.fd = (int)pSocket->s;
+	return epoll_ctl(m_nEpoll, EPOLL_CTL_MOD, (int)pSocket->s, &ev) == 0;
+}
+
+//-----------------------------------------------------------------------------
+// ͹Ҷʱ߶շ
+//-----------------------------------------------------------------------------
+inline int XIoPort::TakeReady(SOCKET s, unsigned int dwEvents, tagIoOp* pReady[2])
+{
+	tagIoSocket* pSocket = LockSocket(s);
+	if (pSocket == nullptr)
+	{
+		return 0;
+	}
+
+	int nNum = 0;
+	bool bError = (dwEvents & (EPOLLERR | EPOLLHUP)) != 0;
+	if (pSocket->pRead && (bError || (dwEvents & EPOLLIN)))
+	{
+		pReady[nNum++] = pSocket->pRead;
+		pSocket->pRead = nullptr;
+	}
+	if (pSocket->pWrite && (bError || (dwEvents & EPOLLOUT)))
+	{
+		pReady[nNum++] = pSocket->pWrite;
+		pSocket->pWrite = nullptr;
+	}
+
+	// ǼʧʱʣµҲȡύʧܲһֱ
+	if (!Arm(pSocket))
+	{
+		if (pSocket->pRead)
+		{
+			pReady[nNum++] = pSocket->pRead;
+			pSocket->pRead = nullptr;
+		}
+		if (pSocket->pWrite)
+		{
+			pReady[nNum++] = pSocket->pWrite;
+			pSocket->pWrite = nullptr;
+		}
+	}
+
+	pSocket->Lock.Unlock();
+	return nNum;
+}
+
+//-----------------------------------------------------------------------------
+inline void XIoPort::Post(XCoroHandle h)
+{
+	m_PostLock.Lock();
+	m_Posted.push_back(h);
+	m_PostLock.Unlock();
+
+	unsigned long long qwOne = 1;
+	(void)write(m_nEvent, &qwOne, sizeof(qwOne));
+}
+
+//-----------------------------------------------------------------------------
+inline void XIoPort::Run()
+{
+	std::vector<XCoroHandle> resume;
+	epoll_event events[64];
+	while (!m_bStop)
+	{
+		int nNum = epoll_wait(m_nEpoll, events, 64, -1);
+		for (int n = 0; n < nNum; ++n)
+		{
+			if (events[n].data.fd == m_nEvent)
+			{
+				unsigned long long qwValue;
+				(void)read(m_nEvent, &qwValue, sizeof(qwValue));
+
+				m_PostLock.Lock();
+				resume.swap(m_Posted);
+				m_PostLock.Unlock();
+
+				for (size_t i = 0; i < resume.size(); ++i)
+				{
+					resume[i].resume();
+				}
+				resume.clear();
+				continue;
+			}
+
+			// һηշûݾ¹
+			tagIoOp* pReady[2];
+			int nReady = TakeReady((SOCKET)events[n].data.fd, events[n].events, pReady);
+			for (int i = 0; i < nReady; ++i)
+			{
+				tagIoOp* pOp = pReady[i];
+				if (!TryComplete(pOp) && Submit(pOp))
+				{
+					continue;
+				}
+				pOp->h.resume();
+			}
+		}
+	}
+
+	// һ߳
+	unsigned long long qwOne = 1;
+	(void)write(m_nEvent, &qwOne, sizeof(qwOne));
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::TryComplete(tagIoOp* pOp)
+{
+	ssize_t nRet = pOp->bWrite
+		? send((int)pOp->s, pOp->pBuf, pOp->dwLen, MSG_DONTWAIT | MSG_NOSIGNAL)
+		: recv((int)pOp->s, pOp->pBuf, pOp->dwLen, MSG_DONTWAIT);
+
+	if (nRet < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+	{
+		return false;
+	}
+
+	pOp->nResult = nRet < 0 ? -1 : (int)nRet;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+inline bool XIoPort::Submit(tagIoOp* pOp)
+{
+	tagIoSocket* pSocket = LockSocket(pOp->s);
+	if (pSocket == nullptr)
+	{
+		pOp->nResult = -1;
+		return false;
+	}
+
+	tagIoOp*& pSlot = pOp->bWrite ? pSocket->pWrite : pSocket->pRead;
+	pSlot = pOp;
+	bool bOK = Arm(pSocket);
+	if (!bOK)
+	{
+		pSlot = nullptr;
+	}
+	pSocket->Lock.Unlock();
+
+	if (!bOK)
+	{
+		pOp->nResult = -1;
+	}
+	return bOK;
+}
+
+#endif // _WIN32
+
+//-----------------------------------------------------------------------------
+// ̡̣߳־ɵĽɺصIO̼߳
+//-----------------------------------------------------------------------------
+template<typename T>
+class XAsyncResult
+{
+public:
+	bool await_ready()
+	{
+		return m_lState == STATE_DONE;
+	}
+
+	bool await_suspend(XCoroHandle h)
+	{
+		m_h = h;
+		// ֮ǰѾɾͲ
+		return ::InterlockedCompareExchange((LPLONG)&m_lState, STATE_WAIT, STATE_NONE) == STATE_NONE;
+	}
+
+	T await_resume()
+	{
+		return m_Result;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ýֻܵһ
+	//-----------------------------------------------------------------------------
+	void SetResult(const T& result)
+	{
+		m_Result = result;
+		if (::InterlockedExchange((LPLONG)&m_lState, STATE_DONE) == STATE_WAIT)
+		{
+			m_pPort->Post(m_h);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	explicit XAsyncResult(XIoPort* pPort)
+		: m_pPort(pPort)
+		, m_lState(STATE_NONE)
+		, m_Result()
+	{
+	}
+
+private:
+	enum
+	{
+		STATE_NONE,
+		STATE_WAIT,
+		STATE_DONE,
+	};
+
+	XIoPort*		m_pPort;
+	LONG volatile	m_lState;
+	XCoroHandle		m_h;
+	T				m_Result;
+};
+
+#endif // XCORO_SUPPORTED
+
+#endif // !__XIOPORT_H__
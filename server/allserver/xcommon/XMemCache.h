@@ -4,6 +4,10 @@
 #define __XMEMCACHE_H__
 
 #include "XMutex.h"
+#include "XTrace.h"
+#include <new>
+#include <thread>
+#include <vector>
 
 #ifdef MEM_TRACE
 #	define NO_MEM_CACHE
@@ -13,10 +17,12 @@
 #	define MCALLOC(dw)		malloc(dw)
 #	define MCREALLOC(p,dw)	realloc(p,dw)
 #	define MCFREE(p)		free(p)
+#	define MCFREEBATCH(pp,n)	{ for (int __n = 0; __n < (n); ++__n) free((pp)[__n]); }
 #else
 #	define MCALLOC(dw)		g_pMemCache->Alloc(dw)
 #	define MCREALLOC(p,dw)	g_pMemCache->ReAlloc(p,dw)
 #	define MCFREE(p)		g_pMemCache->Free(p)
+#	define MCFREEBATCH(pp,n)	g_pMemCache->FreeBatch(pp,n)
 #endif
 
 #ifndef SAFE_MCFREE
@@ -31,30 +37,50 @@ class XMemCache
 {
 public:
 	//-----------------------------------------------------------------------------
-	void* Alloc(unsigned int dwBytes);
+	void* Alloc(unsigned long long qwBytes);
 
 	//-----------------------------------------------------------------------------
 	void Free(void* pMem);
 
 	//-----------------------------------------------------------------------------
-	void* ReAlloc(void* pMem, unsigned int dwNewBytes);
+	void* ReAlloc(void* pMem, unsigned long long qwNewBytes);
 
 	//-----------------------------------------------------------------------------
-	void* TryAlloc(unsigned int dwBytes);
+	void* TryAlloc(unsigned long long qwBytes);
 
 	//-----------------------------------------------------------------------------
 	bool TryFree(void* pMem);
 
 	//-----------------------------------------------------------------------------
-	void SetMaxSize(unsigned int dwSize)
+	// nCountͬСڴ棬ֻһΣвĲһԴϵͳз
+	// ʵʷĿ
+	//-----------------------------------------------------------------------------
+	int AllocBatch(unsigned long long qwBytes, int nCount, void** ppMem);
+
+	//-----------------------------------------------------------------------------
+	// ͷţÿߴֻһΣͬߴĽڵһس
+	//-----------------------------------------------------------------------------
+	void FreeBatch(void** ppMem, int nCount);
+
+	//-----------------------------------------------------------------------------
+	void SetMaxSize(unsigned long long qwSize)
+	{
+		m_qwMaxSize = qwSize;
+	}
+
+	//-----------------------------------------------------------------------------
+	unsigned long long GetFreeSize()
 	{
-		m_dwMaxSize = dwSize;
+		return LoadFreeSize();
 	}
 
 	//-----------------------------------------------------------------------------
-	unsigned int GetFreeSize()
+	// ڴ鰴ߴʵʿôСֱʹóСĲ
+	//-----------------------------------------------------------------------------
+	unsigned long long GetBlockSize(void* pMem)
 	{
-		return m_dwCurrentFreeSize;
+		tagNode* pNode = (tagNode*)(((unsigned char*)pMem) - sizeof(tagNode) + sizeof(void*));
+		return pNode->qwSize;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -70,37 +96,259 @@ public:
 	void SetMemTraceDesc(void* pMem, const char* szDesc);
 
 	//-----------------------------------------------------------------------------
-	XMemCache(unsigned int dwMaxSize = 16 * 1024 * 1024);
+	// Ӧģʽߴı޸δʺϵͳڴѹ̬
+	// m_qwMaxSizeгߴϼƵӲ
+	// ʱ̨߳ÿһΣرʱ˳̵ֻ߳
+	//-----------------------------------------------------------------------------
+	void SetAdaptive(bool bAdaptive);
+
+	//-----------------------------------------------------------------------------
+	bool IsAdaptive() { return m_bAdaptive; }
+
+	//-----------------------------------------------------------------------------
+	// ӦһΣƽʱSetAdaptive̵߳
+	//-----------------------------------------------------------------------------
+	void Adapt();
+
+	//-----------------------------------------------------------------------------
+	// Ѹߴȶʱʹ÷ֵ浽ļ´ʱԤ
+	//-----------------------------------------------------------------------------
+	bool SaveProfile(const char* szFile);
+
+	//-----------------------------------------------------------------------------
+	// ķֵԤȷ䲢ڴҳУnThreads1ʱ߳̽
+	// ԤȵĿȡʧܷ-1
+	//-----------------------------------------------------------------------------
+	int Prewarm(const char* szFile, int nThreads = 1);
+
+	//-----------------------------------------------------------------------------
+	// qwMaxSizeΪ0ʱȡ̿ڴ1/4GetDefaultMaxSize
+	//-----------------------------------------------------------------------------
+	XMemCache(unsigned long long qwMaxSize = 0);
 
 	//-----------------------------------------------------------------------------
 	~XMemCache();
 
+	//-----------------------------------------------------------------------------
+	// m_Poolж룬ͨnew֤ϴʱ͵Ķ
+	//-----------------------------------------------------------------------------
+	static void* operator new(size_t nSize)
+	{
+		void* p = XAlignedAlloc(nSize, alignof(XMemCache));
+		if (p == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		return p;
+	}
+
+	static void operator delete(void* p)
+	{
+		XAlignedFree(p);
+	}
+
 	//---------------------------------------------------------------------------
 	// ռ
 	//---------------------------------------------------------------------------
-	void TryGC(unsigned int dwExpectSize);
+	void TryGC(unsigned long long qwExpectSize);
+
+	//---------------------------------------------------------------------------
+	// ǰϵͳcgroupڴʹðٷֱȣ0-100
+	//---------------------------------------------------------------------------
+	static unsigned int GetMemoryLoad();
+
+	//---------------------------------------------------------------------------
+	// ̿õڴ棬cgroupʱȡСģȡ0
+	//---------------------------------------------------------------------------
+	static unsigned long long GetMemoryTotal();
+
+	//---------------------------------------------------------------------------
+	// ĬϵĿڴޣڴ1/4ȡʱ16M
+	//---------------------------------------------------------------------------
+	static unsigned long long GetDefaultMaxSize()
+	{
+		unsigned long long qwTotal = GetMemoryTotal();
+		return qwTotal ? qwTotal / 4 : 16 * 1024 * 1024;
+	}
 
 private:
+	struct tagSlab;
+	struct tagNode;
+
+	enum
+	{
+		MAX_GC_VISIT	= 256,	// ʱÿߴ࿴ôڵ㣬õĴʱɨ
+		MAX_SLAB_SIZE	= 256 * 1024,	// зõһڴôڵþռסܶڴ
+	};
+
 	//---------------------------------------------------------------------------
 	// ռ
 	//---------------------------------------------------------------------------
-	void GC(unsigned int dwExpectSize, unsigned int dwUseTime);
+	void GC(unsigned long long qwExpectSize, unsigned int dwUseTime);
+
+	//---------------------------------------------------------------------------
+	// ĳߴĿڴָС
+	//---------------------------------------------------------------------------
+	void TrimPool(int nIndex, unsigned long long qwLimit);
+
+	//---------------------------------------------------------------------------
+	// ϵͳnCountڵ㣬MAX_SLAB_SIZEֳɼڴз
+	// һֻͷţߴĽڵһŲ
+	//---------------------------------------------------------------------------
+	int Carve(int nIndex, unsigned long long qwRealSize, int nCount, void** ppMem);
+
+	//---------------------------------------------------------------------------
+	// һڵ㣬ʧܷnullptr
+	//---------------------------------------------------------------------------
+	void* AllocNode(int nIndex, unsigned long long qwRealSize);
+
+	//---------------------------------------------------------------------------
+	// зһڵ㣬ÿڴҳ
+	//---------------------------------------------------------------------------
+	int PrewarmPool(int nIndex, int nCount);
+
+	//---------------------------------------------------------------------------
+	// ͳʹеĿ
+	//---------------------------------------------------------------------------
+	void AddInUse(int nIndex, int nCount)
+	{
+		int nInUse = (int)::InterlockedExchangeAdd((LPLONG)&m_Pool[nIndex].nInUse, nCount) + nCount;
+		if (nInUse > m_Pool[nIndex].nPeakInUse)
+		{
+			m_Pool[nIndex].nPeakInUse = nInUse;	// ͳãҪȷ
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	// ߴ粻ͬһ£ԭӲ
+	//---------------------------------------------------------------------------
+	void AddFreeSize(long long llSize)
+	{
+		::InterlockedExchangeAdd64((LONGLONG volatile*)&m_qwCurrentFreeSize, llSize);
+	}
+
+	//---------------------------------------------------------------------------
+	// 32λ64λĶԭӵ
+	//---------------------------------------------------------------------------
+	unsigned long long LoadFreeSize()
+	{
+#if defined(_WIN64) || defined(__x86_64__)
+		return m_qwCurrentFreeSize;
+#else
+		return (unsigned long long)::InterlockedCompareExchange64((LONGLONG volatile*)&m_qwCurrentFreeSize, 0, 0);
+#endif
+	}
+
+	//---------------------------------------------------------------------------
+	// ӳժһڵ㣬ʱиóߴ
+	//---------------------------------------------------------------------------
+	void UnlinkNode(int nIndex, tagNode* pNode)
+	{
+		if (pNode->pPrev)
+		{
+			pNode->pPrev->pNext = pNode->pNext;
+		}
+		else
+		{
+			m_Pool[nIndex].pFirst = pNode->pNext;
+		}
+
+		if (pNode->pNext)
+		{
+			pNode->pNext->pPrev = pNode->pPrev;
+		}
+		else
+		{
+			m_Pool[nIndex].pLast = pNode->pPrev;
+		}
+
+		--m_Pool[nIndex].nNodeNum;
+		AddFreeSize(-(long long)pNode->qwSize);
+	}
+
+	//---------------------------------------------------------------------------
+	// һڵҵͷʱиóߴ
+	//---------------------------------------------------------------------------
+	void SpliceHead(int nIndex, tagNode* pFirst, tagNode* pLast, int nNum)
+	{
+		pLast->pNext = m_Pool[nIndex].pFirst;
+		if (m_Pool[nIndex].pFirst)
+		{
+			m_Pool[nIndex].pFirst->pPrev = pLast;
+		}
+		else
+		{
+			m_Pool[nIndex].pLast = pLast;
+		}
+		m_Pool[nIndex].pFirst = pFirst;
+		pFirst->pPrev = nullptr;
+
+		m_Pool[nIndex].nNodeNum += nNum;
+		AddFreeSize((long long)(pFirst->qwSize * nNum));
+	}
+
+	//---------------------------------------------------------------------------
+	// зֳĽڵҪգȫڳʱһժ£ժµֽ򷵻0
+	// ʱиóߴ
+	//---------------------------------------------------------------------------
+	unsigned long long UnlinkSlab(int nIndex, tagSlab* pSlab);
+
+	//---------------------------------------------------------------------------
+	// ӳβʱժpNodeͷŵĲ֣Ľڵ㱾鶼еĴڴ
+	// Ҫfreeָ룬ͷʱnullptrʱиóߴ
+	//---------------------------------------------------------------------------
+	void* UnlinkFree(int nIndex, tagNode* pNode, unsigned long long& qwSize);
+
+	//---------------------------------------------------------------------------
+	// ѽڵ黹ϵͳ
+	//---------------------------------------------------------------------------
+	void ReleaseNode(void* pNode);
 
 	//---------------------------------------------------------------------------
 	// ƥĴС
 	//---------------------------------------------------------------------------
-	int GetIndex(unsigned int dwSize, unsigned int& dwRealSize);
+	int GetIndex(unsigned long long qwSize, unsigned long long& qwRealSize);
+
+	//---------------------------------------------------------------------------
+	// ڴǷɴ˽ڵ
+	//---------------------------------------------------------------------------
+	bool CanHold(int nIndex, unsigned long long qwSize)
+	{
+		if (qwSize + LoadFreeSize() > m_qwMaxSize)
+		{
+			return false;
+		}
+
+		if (m_bAdaptive && (unsigned long long)(m_Pool[nIndex].nNodeNum + 1) * qwSize > m_Pool[nIndex].qwLimit)
+		{
+			return false;
+		}
+
+		return true;
+	}
 
 private:
+	// зֵĴڴͷ
+	// ڵ㻹ϵͳͷŲڴ棬ЩڵǷŻسУ
+	// ȫصкGCŰժͷţҲʱſ
+	struct tagSlab
+	{
+		LONG volatile		lRef;		// ûReleaseNodeĽڵֻڽʱ
+		int					nFree;		// ڳеĽڵиóߴʱ޸
+		int					nCount;
+		unsigned int		dwStride;
+	};
+
 	// ڴͷ
 	struct tagNode
 	{
-		tagNode*		pNext;
-		tagNode*		pPrev;
-		int				nIndex;
-		unsigned int	dwSize;
-		unsigned int	dwUseTime;
-		unsigned int	dwFreeTime;	// ãFreeTimeӦõdwUseTime,ֹⲿFree
+		tagNode*			pNext;
+		tagNode*			pPrev;
+		int					nIndex;
+		unsigned int		dwUseTime;
+		unsigned int		dwFreeTime;	// ãFreeTimeӦõdwUseTime,ֹⲿFree
+		unsigned long long	qwSize;
+		tagSlab*			pSlab;		// зĿڴ棬Ϊnullptr
 
 #ifdef MEM_DEBUG
 		DWORD		dwLastAllocSize;
@@ -110,27 +358,45 @@ private:
 		void*		pMem[1];		// ʵڴռ
 	};
 
-	struct
+	// ÿߴһռĻУͬߴ绥
+	struct alignas(64) tagPool
 	{
+		MutexType	Lock;
+
 		int			nNodeNum;
 		int			nAlloc;
+		int			nMiss;			// ûУϵͳĴ
+		int			nInUse;			// ʹõĿ
+		int			nPeakInUse;		// ͳãʹпķֵԤ
+
+		int			nLastAlloc;		// ϴӦʱnAlloc
+		int			nLastMiss;		// ϴӦʱnMiss
+		unsigned long long	qwLimit;	// Ӧģʽ´˳ߴı
 
 		tagNode*	pFirst;
 		tagNode*	pLast;
+
+		tagPool()
+			: nNodeNum(0), nAlloc(0), nMiss(0), nInUse(0), nPeakInUse(0)
+			, nLastAlloc(0), nLastMiss(0), qwLimit(0), pFirst(nullptr), pLast(nullptr)
+		{
+		}
 	} m_Pool[16];
 
 
 private:
 	//---------------------------------------------------------------------------
-	MutexType				m_Lock;						// 
-	//---------------------------------------------------------------------------
-	unsigned int			m_dwMaxSize;				// ⲿ趨ڴ
+	unsigned long long		m_qwMaxSize;				// ⲿ趨ڴ
 	//---------------------------------------------------------------------------
 	bool volatile			m_bTerminate;				// ־,ʱΪ˼ٲGC
 	//---------------------------------------------------------------------------
-	unsigned int volatile 	m_dwCurrentFreeSize;		// ڴпڴ
+	bool volatile			m_bAdaptive;				// Ӧģʽ
+	//---------------------------------------------------------------------------
+	unsigned long long volatile	m_qwCurrentFreeSize;	// ڴпڴ
 	//---------------------------------------------------------------------------
 	unsigned int volatile	m_dwGCTimes;				// ͳãռ
+	//---------------------------------------------------------------------------
+	std::thread				m_AdaptThread;				// Ӧģʽ¶ʱ
 };
 
 //-----------------------------------------------------------------------------
@@ -142,25 +408,27 @@ extern XMemCache<XAtomMutex>*	g_pMemCache;
 // 
 //-----------------------------------------------------------------------------
 template<typename MutexType>
-XMemCache<MutexType>::XMemCache(unsigned int dwMaxSize)
-	: m_dwMaxSize(dwMaxSize)
-	, m_dwCurrentFreeSize(0)
+XMemCache<MutexType>::XMemCache(unsigned long long qwMaxSize)
+	: m_qwMaxSize(qwMaxSize ? qwMaxSize : GetDefaultMaxSize())
 	, m_bTerminate(0)
+	, m_bAdaptive(0)
+	, m_qwCurrentFreeSize(0)
 	, m_dwGCTimes(0)
 {
-	ZeroMemory(m_Pool, sizeof(m_Pool));
 }
 
 template<typename MutexType>
 XMemCache<MutexType>::~XMemCache()
 {
+	SetAdaptive(false);
+
 	for (int n = 0; n < 16; n++)
 	{
 		while (m_Pool[n].pFirst)
 		{
 			tagNode* pNode = m_Pool[n].pFirst;
 			m_Pool[n].pFirst = m_Pool[n].pFirst->pNext;
-			free(pNode);
+			ReleaseNode(pNode);
 		}
 	}
 }
@@ -169,16 +437,18 @@ XMemCache<MutexType>::~XMemCache()
 // 
 //-----------------------------------------------------------------------------
 template<typename MutexType>
-void* XMemCache<MutexType>::Alloc(unsigned int dwBytes)
+void* XMemCache<MutexType>::Alloc(unsigned long long qwBytes)
 {
-	unsigned int dwRealSize = 0;
+	XTRACE_SCOPE("XMemCache::Alloc");
 
-	int nIndex = GetIndex(dwBytes, dwRealSize);
+	unsigned long long qwRealSize = 0;
+
+	int nIndex = GetIndex(qwBytes, qwRealSize);
 	if (-1 != nIndex)
 	{
 		if (m_Pool[nIndex].pFirst)	// ǰ
 		{
-			m_Lock.Lock();
+			XTRACE_LOCK(m_Pool[nIndex].Lock, "XMemCache::LockWait");
 			if (m_Pool[nIndex].pFirst)	// Уʹӳ
 			{
 				tagNode* pNode = m_Pool[nIndex].pFirst;
@@ -191,14 +461,18 @@ void* XMemCache<MutexType>::Alloc(unsigned int dwBytes)
 				{
 					m_Pool[nIndex].pLast = nullptr;
 				}
-				m_dwCurrentFreeSize -= dwRealSize;
+				AddFreeSize(-(long long)qwRealSize);
 				++pNode->dwUseTime;
 				--m_Pool[nIndex].nNodeNum;
 				++m_Pool[nIndex].nAlloc;
-				m_Lock.Unlock();
+				if (pNode->pSlab)
+				{
+					--pNode->pSlab->nFree;
+				}
+				m_Pool[nIndex].Lock.Unlock();
 
 #ifdef MEM_DEBUG
-				for (DWORD n = 0; n<pNode->dwSize; ++n)
+				for (DWORD n = 0; n<pNode->qwSize; ++n)
 				{
 					if (((BYTE*)pNode->pMem)[n] != 0xCD)
 					{
@@ -206,28 +480,40 @@ void* XMemCache<MutexType>::Alloc(unsigned int dwBytes)
 					}
 				}
 
-				pNode->dwLastAllocSize = dwBytes;
+				pNode->dwLastAllocSize = (DWORD)qwBytes;
 #endif
+				AddInUse(nIndex, 1);
 				return pNode->pMem;
 			}
-			m_Lock.Unlock();
+			m_Pool[nIndex].Lock.Unlock();
 		}
 
-		tagNode* pNode = (tagNode*)malloc(dwRealSize + sizeof(tagNode));
-		if (!pNode)
-		{
-			return nullptr;
-		}
+		::InterlockedIncrement((LPLONG)&m_Pool[nIndex].nMiss);
+	}
+	else if (qwRealSize > (size_t)-1 - sizeof(tagNode))
+	{
+		return nullptr;	// 32λ³ַռ
+	}
 
-		pNode->nIndex = nIndex;
-		pNode->dwSize = dwRealSize;
-		pNode->dwUseTime = 0;
-		pNode->dwFreeTime = 0;	// // ãFreeTimeӦõdwUseTime,ֹⲿFree
-		*(unsigned int*)((unsigned char*)pNode->pMem + dwRealSize) = 0xDeadBeef;
-		return pNode->pMem;	// ʵڴз
+	// ûУ򳬹1Mصģʵڴз
+	tagNode* pNode = (tagNode*)malloc((size_t)(qwRealSize + sizeof(tagNode)));
+	if (!pNode)
+	{
+		return nullptr;
 	}
 
-	return nullptr;
+	pNode->nIndex = nIndex;
+	pNode->qwSize = qwRealSize;
+	pNode->pSlab = nullptr;
+	pNode->dwUseTime = 0;
+	pNode->dwFreeTime = 0;	// // ãFreeTimeӦõdwUseTime,ֹⲿFree
+	*(unsigned int*)((unsigned char*)pNode->pMem + qwRealSize) = 0xDeadBeef;
+
+	if (-1 != nIndex)
+	{
+		AddInUse(nIndex, 1);
+	}
+	return pNode->pMem;	// ʵڴз
 }
 
 
@@ -246,26 +532,29 @@ void XMemCache<MutexType>::Free(void* pMem)
 
 	if (m_bTerminate)	// ʱֱӹ黹
 	{
-		free(pNode);
+		ReleaseNode(pNode);
 		return;
 	}
 
 	if (-1 != pNode->nIndex)
 	{
-		if (pNode->dwSize + m_dwCurrentFreeSize > m_dwMaxSize)
+		AddInUse(pNode->nIndex, -1);
+
+		if (pNode->qwSize + LoadFreeSize() > m_qwMaxSize)
 		{
-			GC(pNode->dwSize * 2, pNode->dwUseTime);	// ռ
+			GC(pNode->qwSize * 2, pNode->dwUseTime);	// ռ
 		}
 
-		if (pNode->dwSize + m_dwCurrentFreeSize <= m_dwMaxSize) // ڴؿ
+		// зֳĽڵ㵥ϵͳҲͷŲڴ棬ǷŻس
+		if (pNode->pSlab || CanHold(pNode->nIndex, pNode->qwSize)) // ڴؿ
 		{
-			if (*(unsigned int*)((unsigned char*)pNode->pMem + pNode->dwSize) != 0xDeadBeef)
+			if (*(unsigned int*)((unsigned char*)pNode->pMem + pNode->qwSize) != 0xDeadBeef)
 			{
 				printf("MemCache node corruption!");
 				DebugBreak();
 			}
 
-			m_Lock.Lock();
+			XTRACE_LOCK(m_Pool[pNode->nIndex].Lock, "XMemCache::LockWait");
 
 			// ------------------------------------
 			pNode->pPrev = nullptr;
@@ -287,7 +576,11 @@ void XMemCache<MutexType>::Free(void* pMem)
 
 			m_Pool[pNode->nIndex].pFirst = pNode;
 			++m_Pool[pNode->nIndex].nNodeNum;
-			m_dwCurrentFreeSize += pNode->dwSize;
+			AddFreeSize((long long)pNode->qwSize);
+			if (pNode->pSlab)
+			{
+				++pNode->pSlab->nFree;
+			}
 
 			if (pNode->dwFreeTime != pNode->dwUseTime)
 			{
@@ -297,16 +590,16 @@ void XMemCache<MutexType>::Free(void* pMem)
 			++pNode->dwFreeTime;	// ãFreeTimeӦõdwUseTime,ֹⲿFree
 
 #ifdef MEM_DEBUG
-			memset(pNode->pMem, 0xCD, pNode->dwSize);
+			memset(pNode->pMem, 0xCD, pNode->qwSize);
 #endif
 
 			// ------------------------------------
-			m_Lock.Unlock();
+			m_Pool[pNode->nIndex].Lock.Unlock();
 			return;
 		}
 	}
 
-	free(pNode);
+	ReleaseNode(pNode);
 }
 
 
@@ -314,7 +607,7 @@ void XMemCache<MutexType>::Free(void* pMem)
 // ٷ
 //-----------------------------------------------------------------------------
 template<typename MutexType>
-void* XMemCache<MutexType>::ReAlloc(void* pMem, unsigned int dwNewBytes)
+void* XMemCache<MutexType>::ReAlloc(void* pMem, unsigned long long qwNewBytes)
 {
 	if (pMem == nullptr)
 	{
@@ -322,7 +615,7 @@ void* XMemCache<MutexType>::ReAlloc(void* pMem, unsigned int dwNewBytes)
 	}
 
 	// ڴ
-	void* pNew = Alloc(dwNewBytes);
+	void* pNew = Alloc(qwNewBytes);
 	if (pNew == nullptr)
 	{
 		return nullptr;
@@ -330,7 +623,7 @@ void* XMemCache<MutexType>::ReAlloc(void* pMem, unsigned int dwNewBytes)
 
 	// ȡԭС
 	tagNode* pNode = (tagNode*)(((unsigned char*)pMem) - sizeof(tagNode) + sizeof(void*));
-	memcpy(pNew, pMem, fxmin(pNode->dwSize, dwNewBytes));
+	memcpy(pNew, pMem, fxmin(pNode->qwSize, qwNewBytes));
 
 	// ͷԭڴ
 	Free(pMem);
@@ -342,13 +635,13 @@ void* XMemCache<MutexType>::ReAlloc(void* pMem, unsigned int dwNewBytes)
 // 
 //-----------------------------------------------------------------------------
 template<typename MutexType>
-void* XMemCache<MutexType>::TryAlloc(unsigned int dwBytes)
+void* XMemCache<MutexType>::TryAlloc(unsigned long long qwBytes)
 {
-	unsigned int dwRealSize = 0;
-	int nIndex = GetIndex(dwBytes, dwRealSize);
+	unsigned long long qwRealSize = 0;
+	int nIndex = GetIndex(qwBytes, qwRealSize);
 	if (-1 != nIndex)
 	{
-		if (!m_Lock.TryLock())
+		if (!m_Pool[nIndex].Lock.TryLock())
 		{
 			return nullptr;
 		}
@@ -365,29 +658,38 @@ void* XMemCache<MutexType>::TryAlloc(unsigned int dwBytes)
 			{
 				m_Pool[nIndex].pLast = nullptr;
 			}
-			m_dwCurrentFreeSize -= dwRealSize;
+			AddFreeSize(-(long long)qwRealSize);
 			++pNode->dwUseTime;
 			--m_Pool[nIndex].nNodeNum;
 			++m_Pool[nIndex].nAlloc;
-			m_Lock.Unlock();
+			if (pNode->pSlab)
+			{
+				--pNode->pSlab->nFree;
+			}
+			m_Pool[nIndex].Lock.Unlock();
+			AddInUse(nIndex, 1);
 			return pNode->pMem;
 		}
-		m_Lock.Unlock();
+		m_Pool[nIndex].Lock.Unlock();
+
+		::InterlockedIncrement((LPLONG)&m_Pool[nIndex].nMiss);
 
-		tagNode* pNode = (tagNode*)malloc(dwRealSize + sizeof(tagNode));
+		tagNode* pNode = (tagNode*)malloc((size_t)(qwRealSize + sizeof(tagNode)));
 		if (!pNode)
 		{
 			return nullptr;
 		}
 		pNode->nIndex = nIndex;
-		pNode->dwSize = dwRealSize;
+		pNode->qwSize = qwRealSize;
+		pNode->pSlab = nullptr;
 		pNode->dwUseTime = 0;
 		pNode->dwFreeTime = 0;	// // ãFreeTimeӦõdwUseTime,ֹⲿFree
-		*(unsigned int*)((unsigned char*)pNode->pMem + dwRealSize) = 0xDeadBeef;
+		*(unsigned int*)((unsigned char*)pNode->pMem + qwRealSize) = 0xDeadBeef;
+		AddInUse(nIndex, 1);
 		return pNode->pMem;	// ʵڴз
 	}
 
-	return nullptr
+	return nullptr;
 }
 
 
@@ -406,26 +708,26 @@ bool XMemCache<MutexType>::TryFree(void* pMem)
 
 	if (m_bTerminate)	// ʱֱӹ黹
 	{
-		free(pNode);
+		ReleaseNode(pNode);
 		return true;
 	}
 
 	if (-1 != pNode->nIndex)
 	{
-		if (pNode->dwSize + m_dwCurrentFreeSize > m_dwMaxSize)
+		if (pNode->qwSize + LoadFreeSize() > m_qwMaxSize)
 		{
-			GC(pNode->dwSize * 2, pNode->dwUseTime);	// ռ
+			GC(pNode->qwSize * 2, pNode->dwUseTime);	// ռ
 		}
 
-		if (pNode->dwSize + m_dwCurrentFreeSize <= m_dwMaxSize) // ڴؿ
+		if (pNode->pSlab || CanHold(pNode->nIndex, pNode->qwSize)) // ڴؿ
 		{
-			if (*(unsigned int*)((unsigned char*)pNode->pMem + pNode->dwSize) != 0xDeadBeef)
+			if (*(unsigned int*)((unsigned char*)pNode->pMem + pNode->qwSize) != 0xDeadBeef)
 			{
 				printf("MemCache node corruption!");
 				DebugBreak();
 			}
 
-			if (!m_Lock.TryLock())
+			if (!m_Pool[pNode->nIndex].Lock.TryLock())
 			{
 				return false;
 			}
@@ -448,8 +750,12 @@ bool XMemCache<MutexType>::TryFree(void* pMem)
 			}
 
 			m_Pool[pNode->nIndex].pFirst = pNode;
-			m_dwCurrentFreeSize += pNode->dwSize;
+			AddFreeSize((long long)pNode->qwSize);
 			++m_Pool[pNode->nIndex].nNodeNum;
+			if (pNode->pSlab)
+			{
+				++pNode->pSlab->nFree;
+			}
 
 			if (pNode->dwFreeTime != pNode->dwUseTime)
 			{
@@ -458,203 +764,586 @@ bool XMemCache<MutexType>::TryFree(void* pMem)
 			}
 			++pNode->dwFreeTime;	// ãFreeTimeӦõdwUseTime,ֹⲿFree
 
-			m_Lock.Unlock();
+			m_Pool[pNode->nIndex].Lock.Unlock();
+			AddInUse(pNode->nIndex, -1);
 			return true;
 		}
+
+		AddInUse(pNode->nIndex, -1);
 	}
 
-	free(pNode);
+	ReleaseNode(pNode);
 	return true;
 }
 
 
 //-----------------------------------------------------------------------------
-// ռ
+// 
 //-----------------------------------------------------------------------------
 template<typename MutexType>
-void XMemCache<MutexType>::GC(unsigned int dwExpectSize, unsigned int dwUseTime)
+int XMemCache<MutexType>::AllocBatch(unsigned long long qwBytes, int nCount, void** ppMem)
 {
-	unsigned int dwFreeTime = 0;
+	XTRACE_SCOPE("XMemCache::AllocBatch");
 
-	if (dwExpectSize > m_dwMaxSize / 64)
+	if (nCount <= 0 || ppMem == nullptr)
 	{
-		dwExpectSize = m_dwMaxSize / 64;	// һβҪͷ̫
+		return 0;
 	}
 
-	unsigned int dwFreeSize = 0;
-
-	m_Lock.Lock();
-	++m_dwGCTimes;
-	for (int n = 15; n >= 0; --n)	// Ŀʼ
+	unsigned long long qwRealSize = 0;
+	int nIndex = GetIndex(qwBytes, qwRealSize);
+	if (-1 == nIndex)	// صĴڴ棬
 	{
-		if (!m_Pool[n].pFirst)
-		{
-			continue;
-		}
-
-		tagNode* pNode = m_Pool[n].pLast; // ʼͷţΪNodeʹô
-		while (pNode)
+		for (int n = 0; n < nCount; ++n)
 		{
-			tagNode* pTempNode = pNode;
-			pNode = pNode->pPrev;
-
-			if (pTempNode->dwUseTime >= dwUseTime)
-			{
-				break;	// ǰѾûʺͷŵĽڵˣͺ
-			}
-
-						// ͷŴ˽ڵ
-			if (pNode)
-			{
-				pNode->pNext = pTempNode->pNext;
-			}
-
-			if (pTempNode->pNext)
+			ppMem[n] = Alloc(qwBytes);
+			if (ppMem[n] == nullptr)
 			{
-				pTempNode->pNext->pPrev = pNode;
+				return n;
 			}
+		}
+		return nCount;
+	}
 
-			if (m_Pool[n].pLast == pTempNode)
-			{
-				m_Pool[n].pLast = pNode;
-			}
+	int nGot = 0;
+	if (m_Pool[nIndex].pFirst)	// ǰ
+	{
+		XTRACE_LOCK(m_Pool[nIndex].Lock, "XMemCache::LockWait");
 
-			if (m_Pool[n].pFirst == pTempNode)
+		// ӳͷժһ
+		tagNode* pNode = m_Pool[nIndex].pFirst;
+		while (pNode && nGot < nCount)
+		{
+			++pNode->dwUseTime;
+			if (pNode->pSlab)
 			{
-				m_Pool[n].pFirst = pTempNode->pNext;
+				--pNode->pSlab->nFree;
 			}
+			ppMem[nGot++] = pNode->pMem;
+			pNode = pNode->pNext;
+		}
 
-			m_dwCurrentFreeSize -= pTempNode->dwSize;
-			--m_Pool[n].nNodeNum;
-			dwFreeSize += pTempNode->dwSize;
+		m_Pool[nIndex].pFirst = pNode;
+		if (pNode)
+		{
+			pNode->pPrev = nullptr;
+		}
+		else
+		{
+			m_Pool[nIndex].pLast = nullptr;
+		}
 
-			++dwFreeTime;
-			free(pTempNode);
+		AddFreeSize(-(long long)(qwRealSize * nGot));
+		m_Pool[nIndex].nNodeNum -= nGot;
+		m_Pool[nIndex].nAlloc += nGot;
+		m_Pool[nIndex].Lock.Unlock();
+		AddInUse(nIndex, nGot);
 
-			if (dwFreeSize >= dwExpectSize || dwFreeTime > 32)	// ÿGCҪ̫Free
-			{
-				m_Lock.Unlock();
-				return;
-			}
+#ifdef MEM_DEBUG
+		for (int n = 0; n < nGot; ++n)
+		{
+			tagNode* pDebugNode = (tagNode*)(((unsigned char*)ppMem[n]) - sizeof(tagNode) + sizeof(void*));
+			pDebugNode->dwLastAllocSize = (DWORD)qwBytes;
 		}
+#endif
 	}
 
-	m_Lock.Unlock();
-}
-
+	if (nGot == nCount)
+	{
+		return nCount;
+	}
 
-//-----------------------------------------------------------------------------
-// ƥС
-//-----------------------------------------------------------------------------
-template<typename MutexType>
-int XMemCache<MutexType>::GetIndex(unsigned int dwSize, unsigned int& dwRealSize)
-{
-	if (dwSize <= 32) { dwRealSize = 32;			return 0; }
-	if (dwSize <= 64) { dwRealSize = 64;			return 1; }
-	if (dwSize <= 128) { dwRealSize = 128;			return 2; }
-	if (dwSize <= 256) { dwRealSize = 256;			return 3; }
-	if (dwSize <= 512) { dwRealSize = 512;			return 4; }
-	if (dwSize <= 1024) { dwRealSize = 1024;		return 5; }		//1k
-	if (dwSize <= 2048) { dwRealSize = 2048;		return 6; }		//2k
-	if (dwSize <= 4096) { dwRealSize = 4096;		return 7; }		//4k
-	if (dwSize <= 8192) { dwRealSize = 8192;		return 8; }		//8k
-	if (dwSize <= 16384) { dwRealSize = 16384;		return 9; }		//16k
-	if (dwSize <= 32768) { dwRealSize = 32768;		return 10; }	//32k
-	if (dwSize <= 65536) { dwRealSize = 65536;		return 11; }	//64k
-	if (dwSize <= 131072) { dwRealSize = 131072;	return 12; }	//128k
-	if (dwSize <= 262144) { dwRealSize = 262144;	return 13; }	//256k
-	if (dwSize <= 524288) { dwRealSize = 524288;	return 14; }	//512k
-	if (dwSize <= 1048576) { dwRealSize = 1048576;	return 15; }	//1M
-	dwRealSize = dwSize;
-	return -1;
+	// в㣬ʣµһз
+	::InterlockedExchangeAdd((LPLONG)&m_Pool[nIndex].nMiss, nCount - nGot);
+	int nCarved = Carve(nIndex, qwRealSize, nCount - nGot, ppMem + nGot);
+	AddInUse(nIndex, nCarved);
+	return nGot + nCarved;
 }
 
 
 //-----------------------------------------------------------------------------
-// 
-//-----------------------------------------------------------------------------
-template<typename MutexType>
-void XMemCache<MutexType>::SetMemTraceDesc(void* pMem, const char* szDesc)
-{
-#ifdef MEM_DEBUG
-	tagNode* pNode = (tagNode*)(((LPBYTE)pMem) - sizeof(tagNode) + sizeof(LPVOID));
-	strncpy(pNode->szMemTraceDesc, szDesc, LONG_STRING);
-#endif
-}
-
-//-----------------------------------------------------------------------------
-// ռ
+// ͷ
 //-----------------------------------------------------------------------------
 template<typename MutexType>
-void XMemCache<MutexType>::TryGC(unsigned int dwExpectSize)
+void XMemCache<MutexType>::FreeBatch(void** ppMem, int nCount)
 {
-	static const unsigned int MAX_FREE = 32;
-	tagNode* free_array[MAX_FREE];
-	unsigned int dwFreeTime = 0;
-
-	if (dwExpectSize > m_dwMaxSize / 64)
-	{
-		dwExpectSize = m_dwMaxSize / 64;	// һβҪͷ̫
-	}
-
-	unsigned int dwFreeSize = 0;
+	XTRACE_SCOPE("XMemCache::FreeBatch");
 
-	if (!m_Lock.TryLock())
+	if (nCount <= 0 || ppMem == nullptr)
 	{
 		return;
 	}
 
-	++m_dwGCTimes;
-	for (int n = 15; n >= 0; --n)	// Ŀʼ
+	// 鲢ߴ紮зֳĽڵ㵥һ
+	struct tagChain
 	{
-		if (!m_Pool[n].pFirst)
-		{
-			continue;
-		}
+		tagNode*	pFirst;
+		tagNode*	pLast;
+		int			nNum;
 
-		tagNode* pNode = m_Pool[n].pLast; // ʼͷţΪNodeʹô
-		while (pNode)
+		void Push(tagNode* pNode)
 		{
-			tagNode* pTempNode = pNode;
-			pNode = pNode->pPrev;
-
-			// ͷŴ˽ڵ
-			if (pNode)
+			pNode->pPrev = pLast;
+			pNode->pNext = nullptr;
+			if (pLast)
 			{
-				pNode->pNext = pTempNode->pNext;
+				pLast->pNext = pNode;
 			}
-
-			if (pTempNode->pNext)
+			else
 			{
-				pTempNode->pNext->pPrev = pNode;
+				pFirst = pNode;
 			}
+			pLast = pNode;
+			++nNum;
+		}
+	} chain[16], slab[16];
+	ZeroMemory(chain, sizeof(chain));
+	ZeroMemory(slab, sizeof(slab));
 
-			if (m_Pool[n].pLast == pTempNode)
-			{
-				m_Pool[n].pLast = pNode;
+	unsigned long long qwTotal = 0;
+	unsigned int dwUseTime = 0;
+	for (int n = 0; n < nCount; ++n)
+	{
+		if (ppMem[n] == nullptr)
+		{
+			continue;
+		}
+
+		tagNode* pNode = (tagNode*)(((unsigned char*)ppMem[n]) - sizeof(tagNode) + sizeof(void*));
+		if (m_bTerminate || -1 == pNode->nIndex)
+		{
+			ReleaseNode(pNode);
+			continue;
+		}
+
+		if (*(unsigned int*)((unsigned char*)pNode->pMem + pNode->qwSize) != 0xDeadBeef)
+		{
+			printf("MemCache node corruption!");
+			DebugBreak();
+		}
+
+		if (pNode->dwFreeTime != pNode->dwUseTime)
+		{
+			printf("MemCache Free more than once!");
+			DebugBreak();
+		}
+		++pNode->dwFreeTime;	// ãFreeTimeӦõdwUseTime,ֹⲿFree
+
+#ifdef MEM_DEBUG
+		memset(pNode->pMem, 0xCD, pNode->qwSize);
+#endif
+
+		qwTotal += pNode->qwSize;
+		if (pNode->dwUseTime > dwUseTime)
+		{
+			dwUseTime = pNode->dwUseTime;
+		}
+
+		if (pNode->pSlab)
+		{
+			slab[pNode->nIndex].Push(pNode);
+		}
+		else
+		{
+			chain[pNode->nIndex].Push(pNode);
+		}
+	}
+
+	for (int n = 0; n < 16; ++n)
+	{
+		if (chain[n].nNum + slab[n].nNum)
+		{
+			AddInUse(n, -(chain[n].nNum + slab[n].nNum));
+		}
+	}
+
+	// FreeһŲʱռ
+	if (qwTotal + LoadFreeSize() > m_qwMaxSize)
+	{
+		GC(qwTotal * 2, dwUseTime);
+	}
+
+	tagNode* pFreeList = nullptr;
+
+	for (int n = 0; n < 16; ++n)
+	{
+		if (!chain[n].pFirst && !slab[n].pFirst)
+		{
+			continue;
+		}
+
+		XTRACE_LOCK(m_Pool[n].Lock, "XMemCache::LockWait");
+
+		// зֳĽڵ㲻ƣһ
+		if (slab[n].pFirst)
+		{
+			for (tagNode* pNode = slab[n].pFirst; pNode; pNode = pNode->pNext)
+			{
+				++pNode->pSlab->nFree;
+			}
+			SpliceHead(n, slab[n].pFirst, slab[n].pLast, slab[n].nNum);
+		}
+
+		if (!chain[n].pFirst)
+		{
+			m_Pool[n].Lock.Unlock();
+			continue;
+		}
+
+		// лɶٸ
+		unsigned long long qwRealSize = chain[n].pFirst->qwSize;
+		unsigned long long qwFree = LoadFreeSize();	// ĳߴͬʱڸģֻһ
+		unsigned long long qwRoom = m_qwMaxSize > qwFree ? m_qwMaxSize - qwFree : 0;
+		if (m_bAdaptive)
+		{
+			unsigned long long qwUsed = (unsigned long long)m_Pool[n].nNodeNum * qwRealSize;
+			unsigned long long qwClassRoom = m_Pool[n].qwLimit > qwUsed ? m_Pool[n].qwLimit - qwUsed : 0;
+			if (qwClassRoom < qwRoom)
+			{
+				qwRoom = qwClassRoom;
+			}
+		}
+
+		int nFit = (int)fxmin(qwRoom / qwRealSize, (unsigned long long)chain[n].nNum);
+		if (nFit <= 0)
+		{
+			m_Pool[n].Lock.Unlock();
+			chain[n].pLast->pNext = pFreeList;
+			pFreeList = chain[n].pFirst;
+			continue;
+		}
+
+		// Ųµβͷ
+		tagNode* pLast = chain[n].pLast;
+		if (nFit < chain[n].nNum)
+		{
+			pLast = chain[n].pFirst;
+			for (int i = 1; i < nFit; ++i)
+			{
+				pLast = pLast->pNext;
+			}
+
+			chain[n].pLast->pNext = pFreeList;
+			pFreeList = pLast->pNext;
+		}
+
+		// ҵͷ
+		SpliceHead(n, chain[n].pFirst, pLast, nFit);
+		m_Pool[n].Lock.Unlock();
+	}
+
+	while (pFreeList)
+	{
+		tagNode* pNode = pFreeList;
+		pFreeList = pFreeList->pNext;
+		ReleaseNode(pNode);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// һηڴ沢з
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+int XMemCache<MutexType>::Carve(int nIndex, unsigned long long qwRealSize, int nCount, void** ppMem)
+{
+	// ÿڵ㰴16ֽڶ
+	size_t stStride = ((size_t)qwRealSize + sizeof(tagNode) + 15) & ~(size_t)15;
+	int nPerSlab = (int)((MAX_SLAB_SIZE - sizeof(tagSlab)) / stStride);
+
+	int nDone = 0;
+	while (nDone < nCount && nPerSlab > 1)
+	{
+		int nNum = fxmin(nCount - nDone, nPerSlab);
+		tagSlab* pSlab = (tagSlab*)malloc(sizeof(tagSlab) + stStride * nNum);
+		if (!pSlab)
+		{
+			break;	// ϵͳ䲻˴飬ʣµ
+		}
+
+		pSlab->lRef = nNum;
+		pSlab->nFree = 0;
+		pSlab->nCount = nNum;
+		pSlab->dwStride = (unsigned int)stStride;
+		unsigned char* pBuf = (unsigned char*)(pSlab + 1);
+		for (int n = 0; n < nNum; ++n)
+		{
+			tagNode* pNode = (tagNode*)(pBuf + stStride * n);
+			pNode->nIndex = nIndex;
+			pNode->qwSize = qwRealSize;
+			pNode->pSlab = pSlab;
+			pNode->dwUseTime = 0;
+			pNode->dwFreeTime = 0;
+			*(unsigned int*)((unsigned char*)pNode->pMem + qwRealSize) = 0xDeadBeef;
+			ppMem[nDone + n] = pNode->pMem;
+		}
+		nDone += nNum;
+	}
+
+	for (; nDone < nCount; ++nDone)
+	{
+		ppMem[nDone] = AllocNode(nIndex, qwRealSize);
+		if (!ppMem[nDone])
+		{
+			break;
+		}
+	}
+
+	return nDone;
+}
+
+
+//-----------------------------------------------------------------------------
+// ڵ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void* XMemCache<MutexType>::AllocNode(int nIndex, unsigned long long qwRealSize)
+{
+	tagNode* pNode = (tagNode*)malloc((size_t)(qwRealSize + sizeof(tagNode)));
+	if (!pNode)
+	{
+		return nullptr;
+	}
+
+	pNode->nIndex = nIndex;
+	pNode->qwSize = qwRealSize;
+	pNode->pSlab = nullptr;
+	pNode->dwUseTime = 0;
+	pNode->dwFreeTime = 0;
+	*(unsigned int*)((unsigned char*)pNode->pMem + qwRealSize) = 0xDeadBeef;
+	return pNode->pMem;
+}
+
+
+//-----------------------------------------------------------------------------
+// 黹ڵ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::ReleaseNode(void* pMemNode)
+{
+	tagNode* pNode = (tagNode*)pMemNode;
+	if (pNode->pSlab == nullptr)
+	{
+		free(pNode);
+		return;
+	}
+
+	// зֳĽڵ㣬鶼黹ͷ
+	if (::InterlockedDecrement((LPLONG)&pNode->pSlab->lRef) == 0)
+	{
+		free(pNode->pSlab);
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// ժзֳĽڵ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+unsigned long long XMemCache<MutexType>::UnlinkSlab(int nIndex, tagSlab* pSlab)
+{
+	if (pSlab->nFree < pSlab->nCount)
+	{
+		return 0;	// нڵãͷŲ
+	}
+
+	unsigned long long qwSize = 0;
+	unsigned char* pBuf = (unsigned char*)(pSlab + 1);
+	for (int n = 0; n < pSlab->nCount; ++n)
+	{
+		tagNode* pNode = (tagNode*)(pBuf + (size_t)pSlab->dwStride * n);
+		UnlinkNode(nIndex, pNode);
+		qwSize += pNode->qwSize;
+	}
+	pSlab->nFree = 0;
+	return qwSize;
+}
+
+
+//-----------------------------------------------------------------------------
+// ժ¿ͷŵĲ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void* XMemCache<MutexType>::UnlinkFree(int nIndex, tagNode* pNode, unsigned long long& qwSize)
+{
+	if (pNode->pSlab == nullptr)
+	{
+		UnlinkNode(nIndex, pNode);
+		qwSize = pNode->qwSize;
+		return pNode;
+	}
+
+	tagSlab* pSlab = pNode->pSlab;
+	qwSize = UnlinkSlab(nIndex, pSlab);
+	return qwSize ? pSlab : nullptr;
+}
+
+
+//-----------------------------------------------------------------------------
+// ռ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::GC(unsigned long long qwExpectSize, unsigned int dwUseTime)
+{
+	XTRACE_SCOPE("XMemCache::GC");
+
+	unsigned int dwFreeTime = 0;
+
+	if (qwExpectSize > m_qwMaxSize / 64)
+	{
+		qwExpectSize = m_qwMaxSize / 64;	// һβҪͷ̫
+	}
+
+	unsigned long long qwFreeSize = 0;
+
+	::InterlockedIncrement((LPLONG)&m_dwGCTimes);
+	for (int n = 15; n >= 0; --n)	// Ŀʼգһֻһߴ
+	{
+		if (!m_Pool[n].pFirst)
+		{
+			continue;
+		}
+
+		XTRACE_LOCK(m_Pool[n].Lock, "XMemCache::LockWait");
+
+		int nVisit = 0;
+		tagNode* pNode = m_Pool[n].pLast; // ʼͷţΪNodeʹô
+		while (pNode && ++nVisit <= MAX_GC_VISIT)
+		{
+			tagNode* pTempNode = pNode;
+			pNode = pNode->pPrev;
+
+			if (pTempNode->dwUseTime >= dwUseTime)
+			{
+				break;	// ǰѾûʺͷŵĽڵˣͺ
 			}
 
-			if (m_Pool[n].pFirst == pTempNode)
+			unsigned long long qwSize = 0;
+			void* pFree = UnlinkFree(n, pTempNode, qwSize);
+			if (!pFree)
 			{
-				m_Pool[n].pFirst = pTempNode->pNext;
+				continue;	// ڴ黹нڵã
 			}
 
-			m_dwCurrentFreeSize -= pTempNode->dwSize;
-			--m_Pool[n].nNodeNum;
-			dwFreeSize += pTempNode->dwSize;
+			if (pFree != pTempNode)
+			{
+				pNode = m_Pool[n].pLast;	// ͬһĽڵһժˣpNodeܾУβ
+			}
+
+			qwFreeSize += qwSize;
+			++dwFreeTime;
+			free(pFree);
+
+			if (qwFreeSize >= qwExpectSize || dwFreeTime > 32)	// ÿGCҪ̫Free
+			{
+				m_Pool[n].Lock.Unlock();
+				return;
+			}
+		}
+		m_Pool[n].Lock.Unlock();
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// ƥС
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+int XMemCache<MutexType>::GetIndex(unsigned long long qwSize, unsigned long long& qwRealSize)
+{
+	if (qwSize <= 32) { qwRealSize = 32;			return 0; }
+	if (qwSize <= 64) { qwRealSize = 64;			return 1; }
+	if (qwSize <= 128) { qwRealSize = 128;			return 2; }
+	if (qwSize <= 256) { qwRealSize = 256;			return 3; }
+	if (qwSize <= 512) { qwRealSize = 512;			return 4; }
+	if (qwSize <= 1024) { qwRealSize = 1024;		return 5; }		//1k
+	if (qwSize <= 2048) { qwRealSize = 2048;		return 6; }		//2k
+	if (qwSize <= 4096) { qwRealSize = 4096;		return 7; }		//4k
+	if (qwSize <= 8192) { qwRealSize = 8192;		return 8; }		//8k
+	if (qwSize <= 16384) { qwRealSize = 16384;		return 9; }		//16k
+	if (qwSize <= 32768) { qwRealSize = 32768;		return 10; }	//32k
+	if (qwSize <= 65536) { qwRealSize = 65536;		return 11; }	//64k
+	if (qwSize <= 131072) { qwRealSize = 131072;	return 12; }	//128k
+	if (qwSize <= 262144) { qwRealSize = 262144;	return 13; }	//256k
+	if (qwSize <= 524288) { qwRealSize = 524288;	return 14; }	//512k
+	if (qwSize <= 1048576) { qwRealSize = 1048576;	return 15; }	//1M
+	qwRealSize = qwSize;
+	return -1;
+}
+
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::SetMemTraceDesc(void* pMem, const char* szDesc)
+{
+#ifdef MEM_DEBUG
+	tagNode* pNode = (tagNode*)(((LPBYTE)pMem) - sizeof(tagNode) + sizeof(LPVOID));
+	strncpy(pNode->szMemTraceDesc, szDesc, LONG_STRING);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// ռ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::TryGC(unsigned long long qwExpectSize)
+{
+	XTRACE_SCOPE("XMemCache::TryGC");
+
+	static const unsigned int MAX_FREE = 32;
+	void* free_array[MAX_FREE];
+	unsigned int dwFreeTime = 0;
+
+	if (qwExpectSize > m_qwMaxSize / 64)
+	{
+		qwExpectSize = m_qwMaxSize / 64;	// һβҪͷ̫
+	}
+
+	unsigned long long qwFreeSize = 0;
+
+	::InterlockedIncrement((LPLONG)&m_dwGCTimes);
+	for (int n = 15; n >= 0; --n)	// Ŀʼգϵĳߴ
+	{
+		if (!m_Pool[n].pFirst || !m_Pool[n].Lock.TryLock())
+		{
+			continue;
+		}
+
+		int nVisit = 0;
+		tagNode* pNode = m_Pool[n].pLast; // ʼͷţΪNodeʹô
+		while (pNode && ++nVisit <= MAX_GC_VISIT)
+		{
+			tagNode* pTempNode = pNode;
+			pNode = pNode->pPrev;
+
+			unsigned long long qwSize = 0;
+			void* pFree = UnlinkFree(n, pTempNode, qwSize);
+			if (!pFree)
+			{
+				continue;	// ڴ黹нڵã
+			}
+
+			if (pFree != pTempNode)
+			{
+				pNode = m_Pool[n].pLast;	// ͬһĽڵһժˣβ
+			}
+			qwFreeSize += qwSize;
 
 			// ¼飬Ȼ˳ٽͷ
-			free_array[dwFreeTime++] = pTempNode;
+			free_array[dwFreeTime++] = pFree;
 
-			if (dwFreeSize >= dwExpectSize || dwFreeTime >= MAX_FREE)	// ÿGCҪ̫Free
+			if (qwFreeSize >= qwExpectSize || dwFreeTime >= MAX_FREE)	// ÿGCҪ̫Free
 			{
+				m_Pool[n].Lock.Unlock();
 				goto __out_gc;
 			}
 		}
+		m_Pool[n].Lock.Unlock();
 	}
 
 __out_gc:
-	m_Lock.Unlock();
 
 	for (unsigned int n = 0; n < dwFreeTime; ++n)
 	{
@@ -663,6 +1352,465 @@ __out_gc:
 }
 
 
+//-----------------------------------------------------------------------------
+// Ӧģʽ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::SetAdaptive(bool bAdaptive)
+{
+	if (!bAdaptive)
+	{
+		m_bAdaptive = false;
+		if (m_AdaptThread.joinable())
+		{
+			m_AdaptThread.join();
+		}
+		return;
+	}
+
+	if (m_bAdaptive)
+	{
+		return;
+	}
+
+	for (int n = 0; n < 16; ++n)
+	{
+		m_Pool[n].Lock.Lock();
+		m_Pool[n].qwLimit = m_qwMaxSize / 16;	// ʼƽ䣬֮
+		m_Pool[n].nLastAlloc = m_Pool[n].nAlloc;
+		m_Pool[n].nLastMiss = m_Pool[n].nMiss;
+		m_Pool[n].Lock.Unlock();
+	}
+	m_bAdaptive = true;
+
+	m_AdaptThread = std::thread([this]()
+	{
+		XTRACE_THREAD_NAME("MemCacheAdapt");
+		while (m_bAdaptive)
+		{
+			// ֶ˯رʱõһ
+			for (int n = 0; n < 10 && m_bAdaptive; ++n)
+			{
+				Sleep(100);
+			}
+			Adapt();
+		}
+	});
+}
+
+//-----------------------------------------------------------------------------
+// Ӧ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::Adapt()
+{
+	XTRACE_SCOPE("XMemCache::Adapt");
+
+	if (!m_bAdaptive || m_bTerminate)
+	{
+		return;
+	}
+
+	// ϵͳڴʱ
+	unsigned long long qwBudget = m_qwMaxSize;
+	unsigned int dwLoad = GetMemoryLoad();
+	if (dwLoad >= 90)
+	{
+		qwBudget /= 4;
+	}
+	else if (dwLoad >= 75)
+	{
+		qwBudget /= 2;
+	}
+
+	unsigned long long qwLimit[16];
+	unsigned long long qwTotal = 0;
+	for (int n = 0; n < 16; ++n)
+	{
+		unsigned long long qwRealSize = 32ULL << n;
+		unsigned int dwAlloc = (unsigned int)m_Pool[n].nAlloc - (unsigned int)m_Pool[n].nLastAlloc;
+		unsigned int dwMiss = (unsigned int)m_Pool[n].nMiss - (unsigned int)m_Pool[n].nLastMiss;
+		m_Pool[n].nLastAlloc = m_Pool[n].nAlloc;
+		m_Pool[n].nLastMiss = m_Pool[n].nMiss;
+
+		unsigned long long qwNew = m_Pool[n].qwLimit;
+		if ((unsigned long long)dwMiss * 16 > (unsigned long long)dwAlloc + dwMiss)
+		{
+			// δʳ1/16ʱδ
+			qwNew = qwNew * 2;
+			if (qwNew < qwRealSize * dwMiss)
+			{
+				qwNew = qwRealSize * dwMiss;
+			}
+		}
+		else if (dwMiss == 0)
+		{
+			qwNew -= qwNew / 4;	// ûδУ
+		}
+
+		if (qwNew < qwRealSize)
+		{
+			qwNew = qwRealSize;
+		}
+		if (qwNew > qwBudget)
+		{
+			qwNew = qwBudget;
+		}
+
+		qwLimit[n] = qwNew;
+		qwTotal += qwNew;
+	}
+
+	// ܺͳԤʱ
+	if (qwTotal > qwBudget)
+	{
+		double fScale = (double)qwBudget / (double)qwTotal;
+		for (int n = 0; n < 16; ++n)
+		{
+			qwLimit[n] = (unsigned long long)((double)qwLimit[n] * fScale);
+		}
+	}
+
+	for (int n = 0; n < 16; ++n)
+	{
+		XTRACE_LOCK(m_Pool[n].Lock, "XMemCache::LockWait");
+		m_Pool[n].qwLimit = qwLimit[n];
+		m_Pool[n].Lock.Unlock();
+	}
+
+	for (int n = 0; n < 16; ++n)
+	{
+		if ((unsigned long long)m_Pool[n].nNodeNum * (32ULL << n) > qwLimit[n])
+		{
+			TrimPool(n, qwLimit[n]);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ĳߴĿڴ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XMemCache<MutexType>::TrimPool(int nIndex, unsigned long long qwLimit)
+{
+	static const int MAX_FREE = 64;
+	void* free_array[MAX_FREE];
+	int nFree = 0;
+	unsigned long long qwRealSize = 32ULL << nIndex;
+
+	XTRACE_LOCK(m_Pool[nIndex].Lock, "XMemCache::LockWait");
+	int nVisit = 0;
+	tagNode* pNode = m_Pool[nIndex].pLast;	// Ӻ濪ʼͷţΪNodeʹô
+	while (pNode && nFree < MAX_FREE && ++nVisit <= MAX_GC_VISIT
+		&& (unsigned long long)m_Pool[nIndex].nNodeNum * qwRealSize > qwLimit)
+	{
+		tagNode* pTempNode = pNode;
+		pNode = pNode->pPrev;
+
+		unsigned long long qwSize = 0;
+		void* pFree = UnlinkFree(nIndex, pTempNode, qwSize);
+		if (!pFree)
+		{
+			continue;	// ڴ黹нڵã
+		}
+
+		if (pFree != pTempNode)
+		{
+			pNode = m_Pool[nIndex].pLast;
+		}
+		free_array[nFree++] = pFree;
+	}
+	m_Pool[nIndex].Lock.Unlock();
+
+	// ͷţûһAdapt
+	for (int n = 0; n < nFree; ++n)
+	{
+		free(free_array[n]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ߴʹ÷ֵ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+bool XMemCache<MutexType>::SaveProfile(const char* szFile)
+{
+	FILE* fp = fopen(szFile, "w");
+	if (!fp)
+	{
+		return false;
+	}
+
+	fprintf(fp, "# XMemCache profile: index size peak\n");
+	for (int n = 0; n < 16; ++n)
+	{
+		if (m_Pool[n].nPeakInUse > 0)
+		{
+			fprintf(fp, "%d %llu %d\n", n, 32ULL << n, m_Pool[n].nPeakInUse);
+		}
+	}
+
+	bool bOK = (ferror(fp) == 0);
+	fclose(fp);
+	return bOK;
+}
+
+//-----------------------------------------------------------------------------
+// ķֵԤ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+int XMemCache<MutexType>::Prewarm(const char* szFile, int nThreads)
+{
+	XTRACE_SCOPE("XMemCache::Prewarm");
+
+	FILE* fp = fopen(szFile, "r");
+	if (!fp)
+	{
+		return -1;
+	}
+
+	int nWarm[16];
+	ZeroMemory(nWarm, sizeof(nWarm));
+
+	char szLine[256];
+	while (fgets(szLine, sizeof(szLine), fp))
+	{
+		int nIndex = 0, nPeak = 0;
+		unsigned long long qwSize = 0;
+		if (szLine[0] == '#' || sscanf(szLine, "%d %llu %d", &nIndex, &qwSize, &nPeak) != 3)
+		{
+			continue;
+		}
+
+		// ߴԲϵУ汾
+		if (nIndex < 0 || nIndex >= 16 || qwSize != (32ULL << nIndex) || nPeak <= 0)
+		{
+			continue;
+		}
+		nWarm[nIndex] = nPeak;
+	}
+	fclose(fp);
+
+	// صޣСߴ
+	unsigned long long qwTotal = 0;
+	for (int n = 0; n < 16; ++n)
+	{
+		unsigned long long qwRealSize = 32ULL << n;
+		unsigned long long qwRoom = m_qwMaxSize > qwTotal ? m_qwMaxSize - qwTotal : 0;
+		if ((unsigned long long)nWarm[n] * qwRealSize > qwRoom)
+		{
+			nWarm[n] = (int)(qwRoom / qwRealSize);
+		}
+		qwTotal += (unsigned long long)nWarm[n] * qwRealSize;
+
+		if (m_bAdaptive && nWarm[n] > 0)
+		{
+			m_Pool[n].Lock.Lock();
+			if (m_Pool[n].qwLimit < (unsigned long long)nWarm[n] * qwRealSize)
+			{
+				m_Pool[n].qwLimit = (unsigned long long)nWarm[n] * qwRealSize;	// ԤȵĲ
+			}
+			m_Pool[n].Lock.Unlock();
+		}
+	}
+
+	if (nThreads <= 1)
+	{
+		int nTotal = 0;
+		for (int n = 0; n < 16; ++n)
+		{
+			nTotal += nWarm[n] > 0 ? PrewarmPool(n, nWarm[n]) : 0;
+		}
+		return nTotal;
+	}
+
+	// ߳ʱߴָ̣߳ڴҳҪ
+	LONG volatile lNext = 0;
+	LONG volatile lTotal = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < nThreads; ++t)
+	{
+		threads.emplace_back([this, &nWarm, &lNext, &lTotal]()
+		{
+			XTRACE_THREAD_NAME("MemCachePrewarm");
+			int nIndex;
+			while ((nIndex = (int)::InterlockedIncrement((LPLONG)&lNext) - 1) < 16)
+			{
+				if (nWarm[nIndex] > 0)
+				{
+					::InterlockedExchangeAdd((LPLONG)&lTotal, PrewarmPool(nIndex, nWarm[nIndex]));
+				}
+			}
+		});
+	}
+
+	for (auto& th : threads)
+	{
+		th.join();
+	}
+
+	return (int)lTotal;
+}
+
+//-----------------------------------------------------------------------------
+// Ԥһߴ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+int XMemCache<MutexType>::PrewarmPool(int nIndex, int nCount)
+{
+	XTRACE_SCOPE_ARG("XMemCache::PrewarmPool", nIndex);
+
+	void* pMem[64];
+	unsigned long long qwRealSize = 32ULL << nIndex;
+	int nTotal = 0;
+	while (nTotal < nCount)
+	{
+		int nNum = fxmin(nCount - nTotal, 64);
+		int nGot = Carve(nIndex, qwRealSize, nNum, pMem);
+		for (int n = 0; n < nGot; ++n)
+		{
+			// ÿڴҳдһΣϵͳǰҳ
+			for (unsigned long long qw = 0; qw < qwRealSize; qw += 4096)
+			{
+				((unsigned char volatile*)pMem[n])[qw] = 0;
+			}
+		}
+
+		// FreeBatch۵ʹüȲϣֵ
+		::InterlockedExchangeAdd((LPLONG)&m_Pool[nIndex].nInUse, nGot);
+		FreeBatch(pMem, nGot);
+
+		nTotal += nGot;
+		if (nGot < nNum)
+		{
+			break;	// ϵͳڴ治
+		}
+	}
+
+	return nTotal;
+}
+
+//-----------------------------------------------------------------------------
+// ڴʹðٷֱ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+unsigned int XMemCache<MutexType>::GetMemoryLoad()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX ms;
+	ms.dwLength = sizeof(ms);
+	if (!::GlobalMemoryStatusEx(&ms))
+	{
+		return 0;
+	}
+	return ms.dwMemoryLoad;
+#else
+	auto ReadValue = [](const char* szFile, unsigned long long& qwValue) -> bool
+	{
+		FILE* fp = fopen(szFile, "r");
+		if (!fp)
+		{
+			return false;
+		}
+		bool bOK = (fscanf(fp, "%llu", &qwValue) == 1);	// "max"ʾƣȡʧ
+		fclose(fp);
+		return bOK;
+	};
+
+	// ڴ
+	unsigned long long qwTotal = 0, qwAvail = 0;
+	FILE* fp = fopen("/proc/meminfo", "r");
+	if (fp)
+	{
+		char szLine[256];
+		while (fgets(szLine, sizeof(szLine), fp))
+		{
+			sscanf(szLine, "MemTotal: %llu kB", &qwTotal);
+			sscanf(szLine, "MemAvailable: %llu kB", &qwAvail);
+		}
+		fclose(fp);
+	}
+
+	unsigned int dwLoad = 0;
+	if (qwTotal > 0 && qwAvail <= qwTotal)
+	{
+		dwLoad = (unsigned int)((qwTotal - qwAvail) * 100 / qwTotal);
+	}
+
+	// cgroupƣv2v1ʱֵڴ
+	unsigned long long qwLimit = 0, qwUsage = 0;
+	if ((ReadValue("/sys/fs/cgroup/memory.max", qwLimit) && ReadValue("/sys/fs/cgroup/memory.current", qwUsage))
+		|| (ReadValue("/sys/fs/cgroup/memory/memory.limit_in_bytes", qwLimit) && ReadValue("/sys/fs/cgroup/memory/memory.usage_in_bytes", qwUsage)))
+	{
+		if (qwLimit > 0 && (qwTotal == 0 || qwLimit < qwTotal * 1024))
+		{
+			unsigned int dwCgLoad = (unsigned int)(qwUsage >= qwLimit ? 100 : qwUsage * 100 / qwLimit);
+			if (dwCgLoad > dwLoad)
+			{
+				dwLoad = dwCgLoad;
+			}
+		}
+	}
+
+	return dwLoad;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// ڴ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+unsigned long long XMemCache<MutexType>::GetMemoryTotal()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX ms;
+	ms.dwLength = sizeof(ms);
+	if (!::GlobalMemoryStatusEx(&ms))
+	{
+		return 0;
+	}
+	return ms.ullTotalPhys;
+#else
+	unsigned long long qwTotal = 0;
+	FILE* fp = fopen("/proc/meminfo", "r");
+	if (fp)
+	{
+		char szLine[256];
+		while (fgets(szLine, sizeof(szLine), fp))
+		{
+			if (sscanf(szLine, "MemTotal: %llu kB", &qwTotal) == 1)
+			{
+				qwTotal *= 1024;
+				break;
+			}
+		}
+		fclose(fp);
+	}
+
+	// cgroupƣv2v1"max"֣ڲ
+	const char* szLimitFile[] = { "/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes" };
+	for (int n = 0; n < 2; ++n)
+	{
+		fp = fopen(szLimitFile[n], "r");
+		if (!fp)
+		{
+			continue;
+		}
+
+		unsigned long long qwLimit = 0;
+		if (fscanf(fp, "%llu", &qwLimit) == 1 && qwLimit > 0 && (qwTotal == 0 || qwLimit < qwTotal))
+		{
+			qwTotal = qwLimit;
+		}
+		fclose(fp);
+		break;
+	}
+
+	return qwTotal;
+#endif
+}
+
+
 //---------------------------------------------------------------------------
 //ڴطĶ
 //---------------------------------------------------------------------------
@@ -670,8 +1818,8 @@ class XMemCacheObj
 {
 public:
 #ifndef MEM_TRACE
-	void*			operator new(unsigned int size) { return MCALLOC((unsigned int)size); }
-	void*			operator new[](unsigned int size) { return MCALLOC((unsigned int)size); }
+	void*			operator new(size_t size) { return MCALLOC(size); }
+	void*			operator new[](size_t size) { return MCALLOC(size); }
 	void			operator delete(void* p) { MCFREE(p); }
 	void			operator delete[](void* p) { MCFREE(p); }
 #endif
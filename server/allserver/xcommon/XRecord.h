@@ -0,0 +1,583 @@
+#pragma once
+
+#ifndef __XRECORD_H__
+#define __XRECORD_H__
+
+#include "XDeclare.h"
+#include "XSwapBytes.h"
+
+//-----------------------------------------------------------------------------
+// նƼ¼
+//
+// ֣[¼ܳ4ֽ][ֶδλͼ][][䳤]
+//   ÿֶεƫڱȷڵֶҲռλ0
+//   䳤ֶ˳ŴڵXVarintֶ
+//   ֵֽһɰֽţXSwapBytesת
+// Ϳļеļ¼XRecordViewֱӶҪ
+//
+// ÷
+//   enum { EPF_AccountID, EPF_Name, EPF_Level, EPF_Gold };
+//   typedef XRecordSchema<
+//       XFixed<unsigned int>,		// EPF_AccountID
+//       XBytes<32>,				// EPF_Name
+//       XFixed<unsigned short>,	// EPF_Level
+//       XVarint<long long>			// EPF_Gold
+//   > tagPlayerSchema;
+//
+//   XRecordWriter<tagPlayerSchema> w;
+//   w.Set<EPF_AccountID>(10001);
+//   w.Set<EPF_Gold>(500);
+//   unsigned int dwSize = w.Finish();
+//
+//   XRecordView<tagPlayerSchema> v(w.GetData(), dwSize);
+//   unsigned int dwAccount = v.Get<EPF_AccountID>();
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// ֽֽת
+//-----------------------------------------------------------------------------
+template<unsigned int N> struct XRecordSwap;
+
+template<> struct XRecordSwap<1>
+{
+	typedef unsigned char Type;
+	static Type Swap(Type v) { return v; }
+};
+
+template<> struct XRecordSwap<2>
+{
+	typedef unsigned short Type;
+	static Type Swap(Type v) { return (Type)SwapByte16(v); }
+};
+
+template<> struct XRecordSwap<4>
+{
+	typedef unsigned int Type;
+	static Type Swap(Type v) { return (Type)SwapByte32(v); }
+};
+
+template<> struct XRecordSwap<8>
+{
+	typedef unsigned long long Type;
+	static Type Swap(Type v) { return (Type)SwapByte64(v); }
+};
+
+//-----------------------------------------------------------------------------
+// ֵֶΣ㣩
+//-----------------------------------------------------------------------------
+template<typename T>
+struct XFixed
+{
+	typedef T ValueType;
+	enum { FIXED_SIZE = sizeof(T), IS_VARINT = 0 };
+
+	static void Write(unsigned char* p, const T& v)
+	{
+		typename XRecordSwap<sizeof(T)>::Type raw;
+		memcpy(&raw, &v, sizeof(T));
+		raw = XRecordSwap<sizeof(T)>::Swap(raw);
+		memcpy(p, &raw, sizeof(T));
+	}
+
+	static T Read(const unsigned char* p)
+	{
+		typename XRecordSwap<sizeof(T)>::Type raw;
+		memcpy(&raw, p, sizeof(T));
+		raw = XRecordSwap<sizeof(T)>::Swap(raw);
+		T v;
+		memcpy(&v, &raw, sizeof(T));
+		return v;
+	}
+	static bool Check(const unsigned char*) { return true; }
+};
+
+//-----------------------------------------------------------------------------
+// ֽڴֵȣȡʱֱӷؼ¼ڵָ
+// һֽβ0N-1ַXRecordView::IsValidβ
+//-----------------------------------------------------------------------------
+template<unsigned int N>
+struct XBytes
+{
+	static_assert(N > 0, "XBytes needs room for the terminator");
+
+	typedef const char* ValueType;
+	enum { FIXED_SIZE = N, IS_VARINT = 0 };
+
+	static void Write(unsigned char* p, const char* v)
+	{
+		unsigned int n = 0;
+		for (; v && n < N - 1 && v[n]; ++n)
+		{
+			p[n] = (unsigned char)v[n];
+		}
+		memset(p + n, 0, N - n);
+	}
+
+	static const char* Read(const unsigned char* p)
+	{
+		return (const char*)p;
+	}
+
+	static bool Check(const unsigned char* p)
+	{
+		return p[N - 1] == 0;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// 䳤ֶΣʺϴʱСΪ0ֵзzigzag
+//-----------------------------------------------------------------------------
+template<typename T>
+struct XVarint
+{
+	typedef T ValueType;
+	enum { FIXED_SIZE = 0, IS_VARINT = 1 };
+
+	static unsigned long long ToRaw(T v)
+	{
+		if ((T)-1 < (T)0)	// з
+		{
+			long long n = (long long)v;
+			return ((unsigned long long)n << 1) ^ (unsigned long long)(n >> 63);
+		}
+		return (unsigned long long)v;
+	}
+
+	static T FromRaw(unsigned long long raw)
+	{
+		if ((T)-1 < (T)0)
+		{
+			return (T)(long long)((raw >> 1) ^ (0 - (raw & 1)));
+		}
+		return (T)raw;
+	}
+	static bool Check(const unsigned char*) { return true; }
+};
+
+//-----------------------------------------------------------------------------
+// 䳤
+//-----------------------------------------------------------------------------
+inline unsigned int XVarintEncode(unsigned char* p, unsigned long long raw)
+{
+	unsigned int n = 0;
+	while (raw >= 0x80)
+	{
+		p[n++] = (unsigned char)(raw | 0x80);
+		raw >>= 7;
+	}
+	p[n++] = (unsigned char)raw;
+	return n;
+}
+
+inline unsigned int XVarintDecode(const unsigned char* p, const unsigned char* pEnd, unsigned long long& raw)
+{
+	raw = 0;
+	for (unsigned int n = 0; n < 10 && p + n < pEnd; ++n)
+	{
+		raw |= (unsigned long long)(p[n] & 0x7F) << (7 * n);
+		if (!(p[n] & 0x80))
+		{
+			return n + 1;
+		}
+	}
+	return 0;	// ݴ
+}
+
+//-----------------------------------------------------------------------------
+// ȡNֶ
+//-----------------------------------------------------------------------------
+template<unsigned int N, typename... Fields> struct XRecordFieldAt;
+
+template<typename First, typename... Rest>
+struct XRecordFieldAt<0, First, Rest...>
+{
+	typedef First Type;
+};
+
+template<unsigned int N, typename First, typename... Rest>
+struct XRecordFieldAt<N, First, Rest...>
+{
+	typedef typename XRecordFieldAt<N - 1, Rest...>::Type Type;
+};
+
+//-----------------------------------------------------------------------------
+// ǰNֶεĶܳ
+//-----------------------------------------------------------------------------
+template<unsigned int N, typename... Fields> struct XRecordFixedSum;
+
+template<>
+struct XRecordFixedSum<0>
+{
+	enum { VALUE = 0 };
+};
+
+template<typename First, typename... Rest>
+struct XRecordFixedSum<0, First, Rest...>
+{
+	enum { VALUE = 0 };
+};
+
+template<unsigned int N, typename First, typename... Rest>
+struct XRecordFixedSum<N, First, Rest...>
+{
+	enum { VALUE = (unsigned int)First::FIXED_SIZE + (unsigned int)XRecordFixedSum<N - 1, Rest...>::VALUE };
+};
+
+//-----------------------------------------------------------------------------
+// 䳤ֶθ
+//-----------------------------------------------------------------------------
+template<typename... Fields> struct XRecordVarintNum;
+
+template<>
+struct XRecordVarintNum<>
+{
+	enum { VALUE = 0 };
+};
+
+template<typename First, typename... Rest>
+struct XRecordVarintNum<First, Rest...>
+{
+	enum { VALUE = (unsigned int)First::IS_VARINT + (unsigned int)XRecordVarintNum<Rest...>::VALUE };
+};
+
+//-----------------------------------------------------------------------------
+// ¼ṹ
+//-----------------------------------------------------------------------------
+template<typename... Fields>
+struct XRecordSchema
+{
+	// ԲͬenumǰתC++20enum֮ѲƼ
+	enum { FIELD_NUM = sizeof...(Fields) };
+	enum { HEADER_SIZE = 4 };								// ¼ܳ
+	enum { BITMAP_OFFSET = HEADER_SIZE };
+	enum { BITMAP_SIZE = (FIELD_NUM + 7) / 8 };
+	enum { FIXED_OFFSET = (unsigned int)BITMAP_OFFSET + (unsigned int)BITMAP_SIZE };
+	enum { VARINT_OFFSET = (unsigned int)FIXED_OFFSET + (unsigned int)XRecordFixedSum<FIELD_NUM, Fields...>::VALUE };
+	enum { MAX_SIZE = (unsigned int)VARINT_OFFSET + (unsigned int)XRecordVarintNum<Fields...>::VALUE * 10 };
+
+	// Nֶ
+	template<unsigned int N>
+	struct Field
+	{
+		typedef typename XRecordFieldAt<N, Fields...>::Type Type;
+		typedef typename Type::ValueType ValueType;
+		enum { OFFSET = (unsigned int)FIXED_OFFSET + (unsigned int)XRecordFixedSum<N, Fields...>::VALUE };
+		enum { SIZE = Type::FIXED_SIZE };
+		enum { IS_VARINT = Type::IS_VARINT };
+	};
+};
+
+//-----------------------------------------------------------------------------
+// ǰNֶдڵı䳤ֶΣչ
+//-----------------------------------------------------------------------------
+template<typename Schema, unsigned int N>
+struct XRecordVarintSkip
+{
+	static const unsigned char* Skip(const unsigned char* p, const unsigned char* pEnd, const unsigned char* pBitmap)
+	{
+		p = XRecordVarintSkip<Schema, N - 1>::Skip(p, pEnd, pBitmap);
+		if (p && Schema::template Field<N - 1>::IS_VARINT && (pBitmap[(N - 1) >> 3] & (1 << ((N - 1) & 7))))
+		{
+			unsigned long long raw;
+			unsigned int dwLen = XVarintDecode(p, pEnd, raw);
+			return dwLen ? p + dwLen : nullptr;
+		}
+		return p;
+	}
+};
+
+template<typename Schema>
+struct XRecordVarintSkip<Schema, 0>
+{
+	static const unsigned char* Skip(const unsigned char* p, const unsigned char*, const unsigned char*)
+	{
+		return p;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// ǰNֶεݣĿǰֻXBytesҪ0βչ
+//-----------------------------------------------------------------------------
+template<typename Schema, unsigned int N>
+struct XRecordFieldCheck
+{
+	static bool Check(const unsigned char* pData)
+	{
+		typedef typename Schema::template Field<N - 1>::Type FieldType;
+		return XRecordFieldCheck<Schema, N - 1>::Check(pData)
+			&& FieldType::Check(pData + Schema::template Field<N - 1>::OFFSET);
+	}
+};
+
+template<typename Schema>
+struct XRecordFieldCheck<Schema, 0>
+{
+	static bool Check(const unsigned char*)
+	{
+		return true;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// ֻͼֱ϶ȡ
+//-----------------------------------------------------------------------------
+template<typename Schema>
+class XRecordView
+{
+public:
+	//-----------------------------------------------------------------------------
+	XRecordView(const void* pData, unsigned int dwLen)
+		: m_pData((const unsigned char*)pData)
+		, m_dwLen(dwLen)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	// ȺֽڴβǷϷϷļ¼ܶȡ
+	//-----------------------------------------------------------------------------
+	bool IsValid() const
+	{
+		return m_pData && m_dwLen >= Schema::VARINT_OFFSET && GetSize() >= Schema::VARINT_OFFSET && GetSize() <= m_dwLen
+			&& XRecordFieldCheck<Schema, Schema::FIELD_NUM>::Check(m_pData);
+	}
+
+	//-----------------------------------------------------------------------------
+	unsigned int GetSize() const
+	{
+		return XFixed<unsigned int>::Read(m_pData);
+	}
+
+	//-----------------------------------------------------------------------------
+	const void* GetData() const { return m_pData; }
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	bool Has() const
+	{
+		return (m_pData[Schema::BITMAP_OFFSET + (N >> 3)] & (1 << (N & 7))) != 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ȡֶΣʱֶη0䳤ֶη0
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	typename Schema::template Field<N>::ValueType Get() const
+	{
+		return GetImpl<N>(XIntToType<Schema::template Field<N>::IS_VARINT>());
+	}
+
+	//-----------------------------------------------------------------------------
+	// ֶڼ¼еԭʼֽڣ䳤ֶηرֽ
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	const unsigned char* GetRaw(unsigned int& dwLen) const
+	{
+		if (!Schema::template Field<N>::IS_VARINT)
+		{
+			dwLen = Schema::template Field<N>::SIZE;
+			return m_pData + Schema::template Field<N>::OFFSET;
+		}
+
+		dwLen = 0;
+		if (!Has<N>())
+		{
+			return nullptr;
+		}
+
+		const unsigned char* pEnd = m_pData + GetSize();
+		const unsigned char* p = XRecordVarintSkip<Schema, N>::Skip(m_pData + Schema::VARINT_OFFSET, pEnd, m_pData + Schema::BITMAP_OFFSET);
+		if (!p)
+		{
+			return nullptr;
+		}
+
+		unsigned long long raw;
+		dwLen = XVarintDecode(p, pEnd, raw);
+		return dwLen ? p : nullptr;
+	}
+
+private:
+	template<int V> struct XIntToType {};
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	typename Schema::template Field<N>::ValueType GetImpl(XIntToType<0>) const
+	{
+		typedef typename Schema::template Field<N>::Type FieldType;
+		return FieldType::Read(m_pData + Schema::template Field<N>::OFFSET);
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	typename Schema::template Field<N>::ValueType GetImpl(XIntToType<1>) const
+	{
+		typedef typename Schema::template Field<N>::Type FieldType;
+
+		unsigned int dwLen = 0;
+		const unsigned char* p = GetRaw<N>(dwLen);
+		if (!p)
+		{
+			return FieldType::FromRaw(0);
+		}
+
+		unsigned long long raw;
+		XVarintDecode(p, p + dwLen, raw);
+		return FieldType::FromRaw(raw);
+	}
+
+private:
+	const unsigned char*	m_pData;
+	unsigned int			m_dwLen;
+};
+
+//-----------------------------------------------------------------------------
+// ЩֶǱ䳤ֶΣչ
+//-----------------------------------------------------------------------------
+template<typename Schema, unsigned int N>
+struct XRecordVarintFlags
+{
+	static void Fill(bool* pFlags)
+	{
+		XRecordVarintFlags<Schema, N - 1>::Fill(pFlags);
+		pFlags[N - 1] = Schema::template Field<N - 1>::IS_VARINT != 0;
+	}
+};
+
+template<typename Schema>
+struct XRecordVarintFlags<Schema, 0>
+{
+	static void Fill(bool*) {}
+};
+
+//-----------------------------------------------------------------------------
+// м¼б䳤ֶεԭʼֵ
+//-----------------------------------------------------------------------------
+template<typename Schema, unsigned int N>
+struct XRecordVarintLoad
+{
+	static void Load(const XRecordView<Schema>& view, unsigned long long* pRaw)
+	{
+		XRecordVarintLoad<Schema, N - 1>::Load(view, pRaw);
+		if (Schema::template Field<N - 1>::IS_VARINT)
+		{
+			unsigned int dwLen = 0;
+			const unsigned char* p = view.template GetRaw<N - 1>(dwLen);
+			if (p)
+			{
+				XVarintDecode(p, p + dwLen, pRaw[N - 1]);
+			}
+		}
+	}
+};
+
+template<typename Schema>
+struct XRecordVarintLoad<Schema, 0>
+{
+	static void Load(const XRecordView<Schema>&, unsigned long long*) {}
+};
+
+//-----------------------------------------------------------------------------
+// д¼ֱֶдλã䳤ֶFinishʱα
+// ǻջϣڴ
+//-----------------------------------------------------------------------------
+template<typename Schema>
+class XRecordWriter
+{
+public:
+	//-----------------------------------------------------------------------------
+	XRecordWriter()
+	{
+		Reset();
+	}
+
+	//-----------------------------------------------------------------------------
+	// м¼ʼ޸
+	//-----------------------------------------------------------------------------
+	explicit XRecordWriter(const XRecordView<Schema>& view)
+	{
+		Reset();
+		memcpy(m_byBuf, view.GetData(), Schema::VARINT_OFFSET);
+		XRecordVarintLoad<Schema, Schema::FIELD_NUM>::Load(view, m_qwVarint);
+	}
+
+	//-----------------------------------------------------------------------------
+	void Reset()
+	{
+		memset(m_byBuf, 0, Schema::VARINT_OFFSET);
+		memset(m_qwVarint, 0, sizeof(m_qwVarint));
+		XRecordVarintFlags<Schema, Schema::FIELD_NUM>::Fill(m_bIsVarint);
+		m_dwSize = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void Set(typename Schema::template Field<N>::ValueType v)
+	{
+		m_byBuf[Schema::BITMAP_OFFSET + (N >> 3)] |= (unsigned char)(1 << (N & 7));
+		SetImpl<N>(v, XIntToType<Schema::template Field<N>::IS_VARINT>());
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void Clear()
+	{
+		m_byBuf[Schema::BITMAP_OFFSET + (N >> 3)] &= (unsigned char)~(1 << (N & 7));
+		if (!Schema::template Field<N>::IS_VARINT)
+		{
+			memset(m_byBuf + Schema::template Field<N>::OFFSET, 0, Schema::template Field<N>::SIZE);
+		}
+		m_qwVarint[N] = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	// 䳤ؼ¼ܳ
+	//-----------------------------------------------------------------------------
+	unsigned int Finish()
+	{
+		unsigned int dwPos = Schema::VARINT_OFFSET;
+		for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+		{
+			if (m_bIsVarint[n] && (m_byBuf[Schema::BITMAP_OFFSET + (n >> 3)] & (1 << (n & 7))))
+			{
+				dwPos += XVarintEncode(m_byBuf + dwPos, m_qwVarint[n]);
+			}
+		}
+
+		XFixed<unsigned int>::Write(m_byBuf, dwPos);
+		m_dwSize = dwPos;
+		return dwPos;
+	}
+
+	//-----------------------------------------------------------------------------
+	const void* GetData() const { return m_byBuf; }
+
+	//-----------------------------------------------------------------------------
+	unsigned int GetSize() const { return m_dwSize; }
+
+private:
+	template<int V> struct XIntToType {};
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void SetImpl(typename Schema::template Field<N>::ValueType v, XIntToType<0>)
+	{
+		typedef typename Schema::template Field<N>::Type FieldType;
+		FieldType::Write(m_byBuf + Schema::template Field<N>::OFFSET, v);
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void SetImpl(typename Schema::template Field<N>::ValueType v, XIntToType<1>)
+	{
+		typedef typename Schema::template Field<N>::Type FieldType;
+		m_qwVarint[N] = FieldType::ToRaw(v);
+	}
+
+private:
+	unsigned char		m_byBuf[Schema::MAX_SIZE];
+	unsigned long long	m_qwVarint[Schema::FIELD_NUM];
+	bool				m_bIsVarint[Schema::FIELD_NUM];
+	unsigned int		m_dwSize;
+};
+
+#endif // !__XRECORD_H__
@@ -0,0 +1,458 @@
+#pragma once
+
+#ifndef __XRECORDDELTA_H__
+#define __XRECORDDELTA_H__
+
+#include "XRecord.h"
+
+//-----------------------------------------------------------------------------
+// ¼ֶμ
+//
+// ֣[ܳ4ֽ][仯λͼ][λͼ][仯Ҵڵֵֶ...]
+//   仯λͼЩֶб仯λͼЩֶα仯Ƿ
+//   ֵֶֶ˳ţֶΪֽԭʼֽڣ䳤ֶΪvarint
+// 챾ֽڴֱӷ͡д־ҲֱӴ򵽻ļ¼
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// ֶβ֣ʱ±
+//-----------------------------------------------------------------------------
+struct tagRecordFieldInfo
+{
+	unsigned int	dwOffset;
+	unsigned int	dwSize;
+	bool			bVarint;
+	bool			(*pfnCheck)(const unsigned char* p);	// ֶݼ飬ͬXRecordView::IsValid
+};
+
+template<typename Schema, unsigned int N>
+struct XRecordFieldInfo
+{
+	static void Fill(tagRecordFieldInfo* pInfo)
+	{
+		XRecordFieldInfo<Schema, N - 1>::Fill(pInfo);
+		pInfo[N - 1].dwOffset = Schema::template Field<N - 1>::OFFSET;
+		pInfo[N - 1].dwSize = Schema::template Field<N - 1>::SIZE;
+		pInfo[N - 1].bVarint = Schema::template Field<N - 1>::IS_VARINT != 0;
+		pInfo[N - 1].pfnCheck = &Schema::template Field<N - 1>::Type::Check;
+	}
+};
+
+template<typename Schema>
+struct XRecordFieldInfo<Schema, 0>
+{
+	static void Fill(tagRecordFieldInfo*) {}
+};
+
+//-----------------------------------------------------------------------------
+// ɺӦ
+//-----------------------------------------------------------------------------
+template<typename Schema>
+class XRecordDelta
+{
+public:
+	enum { HEADER_SIZE = 4 };
+	enum { CHANGED_OFFSET = HEADER_SIZE };
+	enum { PRESENT_OFFSET = (unsigned int)CHANGED_OFFSET + (unsigned int)Schema::BITMAP_SIZE };
+	enum { VALUE_OFFSET = (unsigned int)PRESENT_OFFSET + (unsigned int)Schema::BITMAP_SIZE };
+	enum { MAX_SIZE = (unsigned int)VALUE_OFFSET + (unsigned int)Schema::MAX_SIZE - (unsigned int)Schema::FIXED_OFFSET };
+
+	//-----------------------------------------------------------------------------
+	// Ƚ¼дpOutMAX_SIZEز쳤
+	// ûб仯һ¼ϷIsValidΪfalseʱ0
+	//-----------------------------------------------------------------------------
+	static unsigned int Diff(const XRecordView<Schema>& oldView, const XRecordView<Schema>& newView, void* pOut);
+
+	//-----------------------------------------------------------------------------
+	// ֱڼ¼ϴ򲹶dwCapacityΪ¼С
+	// ش򲹶ļ¼ȣ㷵0ʱ¼
+	//-----------------------------------------------------------------------------
+	static unsigned int Patch(void* pRecord, unsigned int dwCapacity, const void* pDelta, unsigned int dwDeltaLen);
+
+	//-----------------------------------------------------------------------------
+	static unsigned int GetSize(const void* pDelta)
+	{
+		return XFixed<unsigned int>::Read((const unsigned char*)pDelta);
+	}
+
+	//-----------------------------------------------------------------------------
+	static const tagRecordFieldInfo* GetFieldInfo()
+	{
+		struct tagLayout
+		{
+			tagRecordFieldInfo info[Schema::FIELD_NUM];
+			tagLayout() { XRecordFieldInfo<Schema, Schema::FIELD_NUM>::Fill(info); }
+		};
+		static const tagLayout layout;
+		return layout.info;
+	}
+
+	//-----------------------------------------------------------------------------
+	static bool TestBit(const unsigned char* pBitmap, unsigned int n)
+	{
+		return (pBitmap[n >> 3] & (1 << (n & 7))) != 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	static void SetBit(unsigned char* pBitmap, unsigned int n, bool bSet)
+	{
+		if (bSet)
+		{
+			pBitmap[n >> 3] |= (unsigned char)(1 << (n & 7));
+		}
+		else
+		{
+			pBitmap[n >> 3] &= (unsigned char)~(1 << (n & 7));
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	// ¼б䳤ֶεԭʼֵʧܷfalse
+	//-----------------------------------------------------------------------------
+	static bool ReadVarints(const unsigned char* pRecord, unsigned int dwSize, unsigned long long* pRaw)
+	{
+		const tagRecordFieldInfo* pInfo = GetFieldInfo();
+		const unsigned char* p = pRecord + Schema::VARINT_OFFSET;
+		const unsigned char* pEnd = pRecord + dwSize;
+		for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+		{
+			pRaw[n] = 0;
+			if (pInfo[n].bVarint && TestBit(pRecord + Schema::BITMAP_OFFSET, n))
+			{
+				unsigned int dwLen = XVarintDecode(p, pEnd, pRaw[n]);
+				if (!dwLen)
+				{
+					return false;
+				}
+				p += dwLen;
+			}
+		}
+		return true;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Ƚ
+//-----------------------------------------------------------------------------
+template<typename Schema>
+unsigned int XRecordDelta<Schema>::Diff(const XRecordView<Schema>& oldView, const XRecordView<Schema>& newView, void* pOut)
+{
+	const unsigned char* pOld = (const unsigned char*)oldView.GetData();
+	const unsigned char* pNew = (const unsigned char*)newView.GetData();
+	unsigned char* pDelta = (unsigned char*)pOut;
+
+	if (!oldView.IsValid() || !newView.IsValid())
+	{
+		return 0;
+	}
+
+	unsigned long long qwOldRaw[Schema::FIELD_NUM];
+	unsigned long long qwNewRaw[Schema::FIELD_NUM];
+	if (!ReadVarints(pOld, oldView.GetSize(), qwOldRaw) || !ReadVarints(pNew, newView.GetSize(), qwNewRaw))
+	{
+		return 0;
+	}
+
+	memset(pDelta + CHANGED_OFFSET, 0, Schema::BITMAP_SIZE * 2);
+
+	const tagRecordFieldInfo* pInfo = GetFieldInfo();
+	bool bAny = false;
+	unsigned int dwPos = VALUE_OFFSET;
+	for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+	{
+		bool bOldHas = TestBit(pOld + Schema::BITMAP_OFFSET, n);
+		bool bNewHas = TestBit(pNew + Schema::BITMAP_OFFSET, n);
+
+		bool bChanged = (bOldHas != bNewHas);
+		if (!bChanged && bNewHas)
+		{
+			if (pInfo[n].bVarint)
+			{
+				bChanged = (qwOldRaw[n] != qwNewRaw[n]);
+			}
+			else
+			{
+				bChanged = (memcmp(pOld + pInfo[n].dwOffset, pNew + pInfo[n].dwOffset, pInfo[n].dwSize) != 0);
+			}
+		}
+
+		if (!bChanged)
+		{
+			continue;
+		}
+
+		bAny = true;
+		SetBit(pDelta + CHANGED_OFFSET, n, true);
+		if (!bNewHas)
+		{
+			continue;
+		}
+
+		SetBit(pDelta + PRESENT_OFFSET, n, true);
+		if (pInfo[n].bVarint)
+		{
+			dwPos += XVarintEncode(pDelta + dwPos, qwNewRaw[n]);
+		}
+		else
+		{
+			memcpy(pDelta + dwPos, pNew + pInfo[n].dwOffset, pInfo[n].dwSize);
+			dwPos += pInfo[n].dwSize;
+		}
+	}
+
+	if (!bAny)
+	{
+		return 0;
+	}
+
+	XFixed<unsigned int>::Write(pDelta, dwPos);
+	return dwPos;
+}
+
+//-----------------------------------------------------------------------------
+// 򲹶
+//-----------------------------------------------------------------------------
+template<typename Schema>
+unsigned int XRecordDelta<Schema>::Patch(void* pRecordBuf, unsigned int dwCapacity, const void* pDeltaBuf, unsigned int dwDeltaLen)
+{
+	unsigned char* pRecord = (unsigned char*)pRecordBuf;
+	const unsigned char* pDelta = (const unsigned char*)pDeltaBuf;
+
+	XRecordView<Schema> view(pRecord, dwCapacity);
+	if (!view.IsValid() || dwDeltaLen < VALUE_OFFSET || GetSize(pDelta) > dwDeltaLen || GetSize(pDelta) < VALUE_OFFSET)
+	{
+		return 0;
+	}
+
+	// ȫ飬ȷܷ޸ļ¼
+	unsigned long long qwRaw[Schema::FIELD_NUM];
+	if (!ReadVarints(pRecord, view.GetSize(), qwRaw))
+	{
+		return 0;
+	}
+
+	const tagRecordFieldInfo* pInfo = GetFieldInfo();
+	const unsigned char* pValue[Schema::FIELD_NUM];
+	const unsigned char* p = pDelta + VALUE_OFFSET;
+	const unsigned char* pEnd = pDelta + GetSize(pDelta);
+
+	unsigned char byPresent[Schema::BITMAP_SIZE];
+	memcpy(byPresent, pRecord + Schema::BITMAP_OFFSET, Schema::BITMAP_SIZE);
+
+	bool bVarintChanged = false;
+	for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+	{
+		pValue[n] = nullptr;
+		if (!TestBit(pDelta + CHANGED_OFFSET, n))
+		{
+			continue;
+		}
+
+		bool bHas = TestBit(pDelta + PRESENT_OFFSET, n);
+		SetBit(byPresent, n, bHas);
+		bVarintChanged = bVarintChanged || pInfo[n].bVarint;
+
+		if (!bHas)
+		{
+			qwRaw[n] = 0;
+			continue;
+		}
+
+		pValue[n] = p;
+		if (pInfo[n].bVarint)
+		{
+			unsigned int dwLen = XVarintDecode(p, pEnd, qwRaw[n]);
+			if (!dwLen)
+			{
+				return 0;
+			}
+			p += dwLen;
+		}
+		else
+		{
+			if (p + pInfo[n].dwSize > pEnd || !pInfo[n].pfnCheck(p))
+			{
+				return 0;	// ȥ¼᲻Ϸ
+			}
+			p += pInfo[n].dwSize;
+		}
+	}
+
+	// 䳤ȿܱ仯
+	unsigned int dwNewSize = view.GetSize();
+	if (bVarintChanged)
+	{
+		unsigned char byTemp[10];
+		dwNewSize = Schema::VARINT_OFFSET;
+		for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+		{
+			if (pInfo[n].bVarint && TestBit(byPresent, n))
+			{
+				dwNewSize += XVarintEncode(byTemp, qwRaw[n]);
+			}
+		}
+
+		if (dwNewSize > dwCapacity)
+		{
+			return 0;
+		}
+	}
+
+	// ʼ޸
+	for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+	{
+		if (pInfo[n].bVarint || !TestBit(pDelta + CHANGED_OFFSET, n))
+		{
+			continue;
+		}
+
+		if (pValue[n])
+		{
+			memcpy(pRecord + pInfo[n].dwOffset, pValue[n], pInfo[n].dwSize);
+		}
+		else
+		{
+			memset(pRecord + pInfo[n].dwOffset, 0, pInfo[n].dwSize);
+		}
+	}
+
+	memcpy(pRecord + Schema::BITMAP_OFFSET, byPresent, Schema::BITMAP_SIZE);
+
+	if (bVarintChanged)
+	{
+		unsigned int dwPos = Schema::VARINT_OFFSET;
+		for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+		{
+			if (pInfo[n].bVarint && TestBit(byPresent, n))
+			{
+				dwPos += XVarintEncode(pRecord + dwPos, qwRaw[n]);
+			}
+		}
+		XFixed<unsigned int>::Write(pRecord, dwPos);
+	}
+
+	return dwNewSize;
+}
+
+//-----------------------------------------------------------------------------
+// Ҫԭ¼ֱӰ޸ĵֶɲ죬Ϸ޸ֶʱʹ
+//-----------------------------------------------------------------------------
+template<typename Schema>
+class XRecordDeltaWriter
+{
+public:
+	//-----------------------------------------------------------------------------
+	XRecordDeltaWriter()
+	{
+		Reset();
+	}
+
+	//-----------------------------------------------------------------------------
+	void Reset()
+	{
+		memset(m_byChanged, 0, sizeof(m_byChanged));
+		memset(m_byPresent, 0, sizeof(m_byPresent));
+		memset(m_byFixed, 0, sizeof(m_byFixed));
+		memset(m_qwVarint, 0, sizeof(m_qwVarint));
+		m_dwSize = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void Set(typename Schema::template Field<N>::ValueType v)
+	{
+		XRecordDelta<Schema>::SetBit(m_byChanged, N, true);
+		XRecordDelta<Schema>::SetBit(m_byPresent, N, true);
+		SetImpl<N>(v, XIntToType<Schema::template Field<N>::IS_VARINT>());
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void Clear()
+	{
+		XRecordDelta<Schema>::SetBit(m_byChanged, N, true);
+		XRecordDelta<Schema>::SetBit(m_byPresent, N, false);
+	}
+
+	//-----------------------------------------------------------------------------
+	// ɲ죬ز쳤ȣû޸ķ0
+	//-----------------------------------------------------------------------------
+	unsigned int Finish()
+	{
+		typedef XRecordDelta<Schema> Delta;
+		const tagRecordFieldInfo* pInfo = Delta::GetFieldInfo();
+
+		bool bAny = false;
+		unsigned int dwPos = Delta::VALUE_OFFSET;
+		for (unsigned int n = 0; n < Schema::FIELD_NUM; ++n)
+		{
+			if (!Delta::TestBit(m_byChanged, n))
+			{
+				continue;
+			}
+
+			bAny = true;
+			if (!Delta::TestBit(m_byPresent, n))
+			{
+				continue;
+			}
+
+			if (pInfo[n].bVarint)
+			{
+				dwPos += XVarintEncode(m_byBuf + dwPos, m_qwVarint[n]);
+			}
+			else
+			{
+				memcpy(m_byBuf + dwPos, m_byFixed + pInfo[n].dwOffset, pInfo[n].dwSize);
+				dwPos += pInfo[n].dwSize;
+			}
+		}
+
+		if (!bAny)
+		{
+			m_dwSize = 0;
+			return 0;
+		}
+
+		memcpy(m_byBuf + Delta::CHANGED_OFFSET, m_byChanged, Schema::BITMAP_SIZE);
+		memcpy(m_byBuf + Delta::PRESENT_OFFSET, m_byPresent, Schema::BITMAP_SIZE);
+		XFixed<unsigned int>::Write(m_byBuf, dwPos);
+		m_dwSize = dwPos;
+		return dwPos;
+	}
+
+	//-----------------------------------------------------------------------------
+	const void* GetData() const { return m_byBuf; }
+
+	//-----------------------------------------------------------------------------
+	unsigned int GetSize() const { return m_dwSize; }
+
+private:
+	template<int V> struct XIntToType {};
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void SetImpl(typename Schema::template Field<N>::ValueType v, XIntToType<0>)
+	{
+		typedef typename Schema::template Field<N>::Type FieldType;
+		FieldType::Write(m_byFixed + Schema::template Field<N>::OFFSET, v);
+	}
+
+	//-----------------------------------------------------------------------------
+	template<unsigned int N>
+	void SetImpl(typename Schema::template Field<N>::ValueType v, XIntToType<1>)
+	{
+		typedef typename Schema::template Field<N>::Type FieldType;
+		m_qwVarint[N] = FieldType::ToRaw(v);
+	}
+
+private:
+	unsigned char		m_byChanged[Schema::BITMAP_SIZE];
+	unsigned char		m_byPresent[Schema::BITMAP_SIZE];
+	unsigned char		m_byFixed[Schema::VARINT_OFFSET];		// ¼еƫݴ涨ֶ
+	unsigned long long	m_qwVarint[Schema::FIELD_NUM];
+	unsigned char		m_byBuf[XRecordDelta<Schema>::MAX_SIZE];
+	unsigned int		m_dwSize;
+};
+
+#endif // !__XRECORDDELTA_H__
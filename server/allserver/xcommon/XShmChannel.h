@@ -0,0 +1,710 @@
+#pragma once
+
+#ifndef __XSHMCHANNEL_H__
+#define __XSHMCHANNEL_H__
+
+#include "XMutex.h"
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#else
+#	include <x86intrin.h>
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <limits.h>
+#	include <string.h>
+#	include <time.h>
+#	include <unistd.h>
+#	include <linux/futex.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/syscall.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// ̼ͬĹڴͨ
+//
+// һڴ棬ϢһϢ
+// ͷڹڴϢ塢ֱдͶʱֻдһƫơȡͣ
+// շֱӶڴϢ壬Freeȫ̲
+//
+// Ϊߵߣͬһڶ߳̿ͬʱͣڼֻһ߳
+// շʱ˯ߣͷֻڶԷ˯ʱŻѣWindows¼Linuxfutex
+// ߴּ飬пô汾ŵջ̶Էͷ
+//-----------------------------------------------------------------------------
+class XShmChannel
+{
+public:
+	enum
+	{
+		CLASS_COUNT		= 5,			// 256B 1K 4K 16K 64K
+		MIN_BLOCK_SIZE	= 256,
+		MAX_MSG_SIZE	= MIN_BLOCK_SIZE << (2 * (CLASS_COUNT - 1)),
+		SPIN_COUNT		= 2000,			// ˯ǰת
+		MAGIC			= 0x584D4853,	// "SHMX"
+	};
+
+	//-----------------------------------------------------------------------------
+	// յϢpDataָڴ棬Free
+	//-----------------------------------------------------------------------------
+	struct tagShmMsg
+	{
+		void*	pData;
+		DWORD	dwLen;
+		DWORD	dwType;
+	};
+
+	//-----------------------------------------------------------------------------
+	// ͨqwSizeΪڴܴСdwRingSizeΪÿϢޣ2ݣ
+	//-----------------------------------------------------------------------------
+	bool Create(const char* szName, unsigned long long qwSize = 64 * 1024 * 1024, DWORD dwRingSize = 4096);
+
+	//-----------------------------------------------------------------------------
+	// һ̴ͨ
+	//-----------------------------------------------------------------------------
+	bool Open(const char* szName);
+
+	void Close();
+
+	//-----------------------------------------------------------------------------
+	// ڹڴϢ壬˷nullptr
+	//-----------------------------------------------------------------------------
+	void* Alloc(DWORD dwLen);
+
+	//-----------------------------------------------------------------------------
+	// 黹Ϣ壬AllocûͶݵĺյĶԣһ黹
+	// ǱͨĿʼַʱ
+	//-----------------------------------------------------------------------------
+	void Free(void* pData);
+
+	//-----------------------------------------------------------------------------
+	// ͶAllocϢ壬ɹȨԷfalseϢԹ
+	//-----------------------------------------------------------------------------
+	bool Post(void* pData, DWORD dwLen, DWORD dwType);
+
+	//-----------------------------------------------------------------------------
+	// һͶݣֱڹڴﹹĵ
+	//-----------------------------------------------------------------------------
+	bool Send(const void* pData, DWORD dwLen, DWORD dwType);
+
+	//-----------------------------------------------------------------------------
+	// һûϢʱȴdwTimeout룬ʱfalse
+	// ԶԷ̣ƫƲǿʼ򳤶ȳСֱӶ
+	//-----------------------------------------------------------------------------
+	bool Recv(tagShmMsg& msg, DWORD dwTimeout);
+
+	//-----------------------------------------------------------------------------
+	// ñRecv˯ߵ̷߳falseֹͣʱ
+	//-----------------------------------------------------------------------------
+	void Interrupt();
+
+	//-----------------------------------------------------------------------------
+	bool IsOpen() { return m_pHeader != nullptr; }
+
+	//-----------------------------------------------------------------------------
+	XShmChannel();
+	~XShmChannel();
+
+private:
+	// Ϣֻƫƣӳĵַͬ
+	// Ľṹöͣ߱Ĳһ
+	struct tagShmDesc
+	{
+		unsigned long long		qwOffset;
+		unsigned int			dwLen;
+		unsigned int			dwType;
+	};
+
+	//-----------------------------------------------------------------------------
+	// һϢߺ߸дĻ
+	//-----------------------------------------------------------------------------
+	struct tagShmRing
+	{
+		unsigned int volatile	dwTail;			// д
+		char					Pad1[60];
+		unsigned int volatile	dwHead;			// д
+		LONG volatile			lSleeping;		// ڻҪ˯
+		LONG volatile			lWakeSeq;		// ÿλѼһfutexȴ
+		char					Pad2[52];
+		unsigned long long		qwDescOffset;	// λ
+		char					Pad3[56];
+	};
+
+	//-----------------------------------------------------------------------------
+	// һ飬ջΪ 汾 << 32 | ( + 1)0Ϊ
+	//-----------------------------------------------------------------------------
+	struct tagShmClass
+	{
+		LONGLONG volatile		llTop;
+		char					Pad[56];
+		unsigned long long		qwOffset;
+		unsigned int			dwBlockSize;
+		unsigned int			dwCount;
+		char					Pad2[48];
+	};
+
+	struct tagShmHeader
+	{
+		unsigned int volatile	dwMagic;		// ʼɺд
+		unsigned int			dwRingSize;
+		unsigned long long		qwSize;
+		char					Pad[48];
+		tagShmRing				Ring[2];		// 0Ϊ1Ϊ򿪷
+		tagShmClass				Class[CLASS_COUNT];
+	};
+
+	//-----------------------------------------------------------------------------
+	unsigned char* GetBase() { return (unsigned char*)m_pHeader; }
+
+	tagShmDesc* GetDesc(tagShmRing& ring, unsigned int dwIndex)
+	{
+		return (tagShmDesc*)(GetBase() + ring.qwDescOffset) + (dwIndex & (m_pHeader->dwRingSize - 1));
+	}
+
+	tagShmRing& GetSendRing() { return m_pHeader->Ring[m_bCreator ? 0 : 1]; }
+	tagShmRing& GetRecvRing() { return m_pHeader->Ring[m_bCreator ? 1 : 0]; }
+
+	//-----------------------------------------------------------------------------
+	// ƫڵĵĳһʼ򷵻nullptr
+	//-----------------------------------------------------------------------------
+	tagShmClass* FindClass(unsigned long long qwOffset);
+
+	bool CheckLayout();
+
+	bool Map(const char* szName, unsigned long long qwSize, bool bCreate);
+	void Push(tagShmClass& cls, unsigned int dwIndex);
+	void Wake(int nRing);
+	void Wait(int nRing, LONG lSeq, DWORD dwTimeout);
+
+	//-----------------------------------------------------------------------------
+	static unsigned long long GetTickMs()
+	{
+#ifdef _WIN32
+		return ::GetTickCount64();
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+	}
+
+	tagShmHeader*		m_pHeader;
+	unsigned long long	m_qwMapSize;
+	bool				m_bCreator;
+	bool volatile		m_bInterrupted;	// Interrupt´ʱ
+	XMutex				m_SendLock;		// ڶ̷߳ʱ
+	char				m_szName[128];
+
+#ifdef _WIN32
+	HANDLE				m_hMapping;
+	HANDLE				m_hEvent[2];	// ÿߵڶӦ¼
+#else
+	int					m_nFd;
+#endif
+};
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+inline XShmChannel::XShmChannel()
+	: m_pHeader(nullptr)
+	, m_qwMapSize(0)
+	, m_bCreator(false)
+	, m_bInterrupted(false)
+#ifdef _WIN32
+	, m_hMapping(NULL)
+#else
+	, m_nFd(-1)
+#endif
+{
+	m_szName[0] = 0;
+#ifdef _WIN32
+	m_hEvent[0] = m_hEvent[1] = NULL;
+#endif
+}
+
+inline XShmChannel::~XShmChannel()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+// ͷ飬ʣµƽָ
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::Create(const char* szName, unsigned long long qwSize, DWORD dwRingSize)
+{
+	if (dwRingSize == 0 || (dwRingSize & (dwRingSize - 1)) != 0)
+	{
+		return false;
+	}
+
+	unsigned long long qwHeader = (sizeof(tagShmHeader) + 63) & ~63ULL;
+	unsigned long long qwDesc = (2ULL * dwRingSize * sizeof(tagShmDesc) + 63) & ~63ULL;
+	if (qwSize < qwHeader + qwDesc + (unsigned long long)MAX_MSG_SIZE * CLASS_COUNT)
+	{
+		return false;
+	}
+
+	m_bCreator = true;
+	if (!Map(szName, qwSize, true))
+	{
+		return false;
+	}
+
+	tagShmHeader* pHeader = m_pHeader;
+	ZeroMemory(pHeader, (size_t)qwHeader);
+	pHeader->dwRingSize = dwRingSize;
+	pHeader->qwSize = qwSize;
+	pHeader->Ring[0].qwDescOffset = qwHeader;
+	pHeader->Ring[1].qwDescOffset = qwHeader + dwRingSize * sizeof(tagShmDesc);
+
+	unsigned long long qwOffset = qwHeader + qwDesc;
+	unsigned long long qwShare = ((qwSize - qwOffset) / CLASS_COUNT) & ~63ULL;
+	for (int n = 0; n < CLASS_COUNT; ++n)
+	{
+		tagShmClass& cls = pHeader->Class[n];
+		cls.qwOffset = qwOffset;
+		cls.dwBlockSize = MIN_BLOCK_SIZE << (2 * n);
+		cls.dwCount = (unsigned int)(qwShare / cls.dwBlockSize);
+		cls.llTop = 0;
+		for (unsigned int i = cls.dwCount; i > 0; --i)	// ѹջȷ͵ַĿ
+		{
+			Push(cls, i - 1);
+		}
+		qwOffset += qwShare;
+	}
+
+	::InterlockedExchange((LPLONG)&pHeader->dwMagic, MAGIC);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::Open(const char* szName)
+{
+	m_bCreator = false;
+	if (!Map(szName, 0, false))
+	{
+		return false;
+	}
+
+	if (m_pHeader->dwMagic != MAGIC || !CheckLayout())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// 򿪷ͷĲ֣͸Ҫӳ䷶Χڣ֮ЩƫƷʲŲԽ
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::CheckLayout()
+{
+	tagShmHeader* pHeader = m_pHeader;
+	unsigned int dwRingSize = pHeader->dwRingSize;
+	if (dwRingSize == 0 || (dwRingSize & (dwRingSize - 1)) != 0 || pHeader->qwSize > m_qwMapSize)
+	{
+		return false;
+	}
+
+	unsigned long long qwDescSize = (unsigned long long)dwRingSize * sizeof(tagShmDesc);
+	for (int n = 0; n < 2; ++n)
+	{
+		unsigned long long qwOffset = pHeader->Ring[n].qwDescOffset;
+		if (qwOffset < sizeof(tagShmHeader) || qwOffset > m_qwMapSize || m_qwMapSize - qwOffset < qwDescSize)
+		{
+			return false;
+		}
+	}
+
+	for (int n = 0; n < CLASS_COUNT; ++n)
+	{
+		tagShmClass& cls = pHeader->Class[n];
+		if (cls.dwBlockSize != (unsigned int)(MIN_BLOCK_SIZE << (2 * n)) || cls.qwOffset > m_qwMapSize
+			|| m_qwMapSize - cls.qwOffset < (unsigned long long)cls.dwCount * cls.dwBlockSize)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// ӳ¼qwSizeΪ0ʱеĴС
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::Map(const char* szName, unsigned long long qwSize, bool bCreate)
+{
+	strncpy(m_szName, szName, sizeof(m_szName) - 1);
+	m_szName[sizeof(m_szName) - 1] = 0;
+
+#ifdef _WIN32
+	char szObject[160];
+	_snprintf_s(szObject, sizeof(szObject), _TRUNCATE, "Local\\%s", szName);
+	if (bCreate)
+	{
+		m_hMapping = ::CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+			(DWORD)(qwSize >> 32), (DWORD)qwSize, szObject);
+		if (m_hMapping && ::GetLastError() == ERROR_ALREADY_EXISTS)
+		{
+			::CloseHandle(m_hMapping);
+			m_hMapping = NULL;
+		}
+	}
+	else
+	{
+		m_hMapping = ::OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, szObject);
+	}
+
+	if (!m_hMapping)
+	{
+		return false;
+	}
+
+	m_pHeader = (tagShmHeader*)::MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!m_pHeader)
+	{
+		Close();
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION mbi;
+	::VirtualQuery(m_pHeader, &mbi, sizeof(mbi));
+	m_qwMapSize = mbi.RegionSize;
+
+	for (int n = 0; n < 2; ++n)
+	{
+		_snprintf_s(szObject, sizeof(szObject), _TRUNCATE, "Local\\%s_wake%d", szName, n);
+		m_hEvent[n] = ::CreateEventA(NULL, FALSE, FALSE, szObject);
+		if (!m_hEvent[n])
+		{
+			Close();
+			return false;
+		}
+	}
+	return true;
+#else
+	char szObject[160];
+	snprintf(szObject, sizeof(szObject), "/%s", szName);
+	if (bCreate)
+	{
+		shm_unlink(szObject);	// ϴ쳣˳µ
+	}
+	m_nFd = bCreate ? shm_open(szObject, O_CREAT | O_EXCL | O_RDWR, 0600) : shm_open(szObject, O_RDWR, 0);
+	if (m_nFd < 0)
+	{
+		return false;
+	}
+
+	if (bCreate)
+	{
+		if (ftruncate(m_nFd, (off_t)qwSize) != 0)
+		{
+			Close();
+			return false;
+		}
+	}
+	else
+	{
+		struct stat st;
+		if (fstat(m_nFd, &st) != 0 || (unsigned long long)st.st_size < sizeof(tagShmHeader))
+		{
+			Close();
+			return false;
+		}
+		qwSize = (unsigned long long)st.st_size;
+	}
+
+	void* p = mmap(NULL, (size_t)qwSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_nFd, 0);
+	if (p == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	m_pHeader = (tagShmHeader*)p;
+	m_qwMapSize = qwSize;
+	return true;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// رգͬʱɾ֣Ѵ򿪵һӰ
+//-----------------------------------------------------------------------------
+inline void XShmChannel::Close()
+{
+#ifdef _WIN32
+	if (m_pHeader)
+	{
+		::UnmapViewOfFile(m_pHeader);
+	}
+	if (m_hMapping)
+	{
+		::CloseHandle(m_hMapping);
+	}
+	for (int n = 0; n < 2; ++n)
+	{
+		if (m_hEvent[n])
+		{
+			::CloseHandle(m_hEvent[n]);
+			m_hEvent[n] = NULL;
+		}
+	}
+	m_hMapping = NULL;
+#else
+	if (m_pHeader)
+	{
+		munmap(m_pHeader, (size_t)m_qwMapSize);
+	}
+	if (m_nFd >= 0)
+	{
+		close(m_nFd);
+		if (m_bCreator)
+		{
+			char szObject[160];
+			snprintf(szObject, sizeof(szObject), "/%s", m_szName);
+			shm_unlink(szObject);
+		}
+	}
+	m_nFd = -1;
+#endif
+	m_pHeader = nullptr;
+	m_qwMapSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+// ܷµСһȡһ飬һ˾
+//-----------------------------------------------------------------------------
+inline void* XShmChannel::Alloc(DWORD dwLen)
+{
+	for (int n = 0; n < CLASS_COUNT; ++n)
+	{
+		tagShmClass& cls = m_pHeader->Class[n];
+		if (dwLen > cls.dwBlockSize)
+		{
+			continue;
+		}
+
+		for (;;)
+		{
+			LONGLONG llTop = ::InterlockedCompareExchange64(&cls.llTop, 0, 0);
+			unsigned int dwSlot = (unsigned int)llTop;
+			if (dwSlot == 0 || dwSlot > cls.dwCount)
+			{
+				break;	// ˣջԷд
+			}
+
+			// ˿ܸհߣnextģ汾ŻCASʧ
+			unsigned char* pBlock = GetBase() + cls.qwOffset + (unsigned long long)(dwSlot - 1) * cls.dwBlockSize;
+			unsigned int dwNext = *(unsigned int volatile*)pBlock;
+			LONGLONG llNew = ((LONGLONG)((unsigned long long)llTop >> 32) + 1) << 32 | dwNext;
+			if (::InterlockedCompareExchange64(&cls.llTop, llNew, llTop) == llTop)
+			{
+				return pBlock;
+			}
+		}
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// ƫҵڵĵ
+//-----------------------------------------------------------------------------
+inline void XShmChannel::Free(void* pData)
+{
+	if (pData == nullptr)
+	{
+		return;
+	}
+
+	unsigned long long qwOffset = (unsigned long long)((unsigned char*)pData - GetBase());
+	tagShmClass* pClass = FindClass(qwOffset);
+	if (pClass)
+	{
+		Push(*pClass, (unsigned int)((qwOffset - pClass->qwOffset) / pClass->dwBlockSize));
+	}
+}
+
+//-----------------------------------------------------------------------------
+// λúʹСֻڴʱдָֻ֮ڵַȻַСʱƳɺܴһ鲻
+//-----------------------------------------------------------------------------
+inline XShmChannel::tagShmClass* XShmChannel::FindClass(unsigned long long qwOffset)
+{
+	for (int n = 0; n < CLASS_COUNT; ++n)
+	{
+		tagShmClass& cls = m_pHeader->Class[n];
+		if (qwOffset < cls.qwOffset)
+		{
+			continue;
+		}
+
+		unsigned long long qwRel = qwOffset - cls.qwOffset;
+		if (qwRel < (unsigned long long)cls.dwCount * cls.dwBlockSize)
+		{
+			return qwRel % cls.dwBlockSize == 0 ? &cls : nullptr;
+		}
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+inline void XShmChannel::Push(tagShmClass& cls, unsigned int dwIndex)
+{
+	unsigned char* pBlock = GetBase() + cls.qwOffset + (unsigned long long)dwIndex * cls.dwBlockSize;
+	for (;;)
+	{
+		LONGLONG llTop = ::InterlockedCompareExchange64(&cls.llTop, 0, 0);
+		*(unsigned int volatile*)pBlock = (unsigned int)llTop;
+		LONGLONG llNew = ((LONGLONG)((unsigned long long)llTop >> 32) + 1) << 32 | (dwIndex + 1);
+		if (::InterlockedCompareExchange64(&cls.llTop, llNew, llTop) == llTop)
+		{
+			return;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// дƽβԷ˯ŲŻ
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::Post(void* pData, DWORD dwLen, DWORD dwType)
+{
+	tagShmRing& ring = GetSendRing();
+
+	m_SendLock.Lock();
+	unsigned int dwTail = ring.dwTail;
+	if (dwTail - ring.dwHead >= m_pHeader->dwRingSize)
+	{
+		m_SendLock.Unlock();
+		return false;	// 
+	}
+
+	tagShmDesc* pDesc = GetDesc(ring, dwTail);
+	pDesc->qwOffset = (unsigned char*)pData - GetBase();
+	pDesc->dwLen = dwLen;
+	pDesc->dwType = dwType;
+
+	// ȫϣβɼٿԷǷ˯
+	::InterlockedExchange((LPLONG)&ring.dwTail, (LONG)(dwTail + 1));
+	m_SendLock.Unlock();
+
+	if (ring.lSleeping && ::InterlockedExchange(&ring.lSleeping, 0))
+	{
+		Wake(m_bCreator ? 0 : 1);
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::Send(const void* pData, DWORD dwLen, DWORD dwType)
+{
+	void* p = Alloc(dwLen);
+	if (!p)
+	{
+		return false;
+	}
+
+	memcpy(p, pData, dwLen);
+	if (!Post(p, dwLen, dwType))
+	{
+		Free(p);
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// ȿתһᣬûвҪ˯ٲһΣͷͷ
+//-----------------------------------------------------------------------------
+inline bool XShmChannel::Recv(tagShmMsg& msg, DWORD dwTimeout)
+{
+	int nRing = m_bCreator ? 1 : 0;
+	tagShmRing& ring = GetRecvRing();
+	unsigned int dwHead = ring.dwHead;
+
+	unsigned long long qwDeadline = 0;
+	for (int nSpin = 0; ; ++nSpin)
+	{
+		if (ring.dwTail != dwHead)
+		{
+			// ȿüԷٸ
+			tagShmDesc desc = *GetDesc(ring, dwHead);
+			::InterlockedExchange((LPLONG)&ring.dwHead, (LONG)(++dwHead));
+
+			tagShmClass* pClass = FindClass(desc.qwOffset);
+			if (pClass == nullptr || desc.dwLen > pClass->dwBlockSize)
+			{
+				continue;	// 鲻֪˭ģ黹
+			}
+
+			msg.pData = GetBase() + desc.qwOffset;
+			msg.dwLen = desc.dwLen;
+			msg.dwType = desc.dwType;
+			return true;
+		}
+
+		if (nSpin < SPIN_COUNT)
+		{
+			_mm_pause();
+			continue;
+		}
+
+		// ѿһµģûʱͽŵ
+		unsigned long long qwNow = GetTickMs();
+		if (qwDeadline == 0)
+		{
+			qwDeadline = qwNow + dwTimeout;
+		}
+		if (qwNow >= qwDeadline || m_bInterrupted)
+		{
+			m_bInterrupted = false;
+			return false;
+		}
+
+		LONG lSeq = ring.lWakeSeq;
+		::InterlockedExchange(&ring.lSleeping, 1);
+		if (ring.dwTail == dwHead)
+		{
+			Wait(nRing, lSeq, (DWORD)(qwDeadline - qwNow));
+		}
+		::InterlockedExchange(&ring.lSleeping, 0);
+	}
+}
+
+//-----------------------------------------------------------------------------
+inline void XShmChannel::Interrupt()
+{
+	m_bInterrupted = true;
+	Wake(m_bCreator ? 1 : 0);
+}
+
+//-----------------------------------------------------------------------------
+// ѵnRingϵ
+//-----------------------------------------------------------------------------
+inline void XShmChannel::Wake(int nRing)
+{
+#ifdef _WIN32
+	::SetEvent(m_hEvent[nRing]);
+#else
+	::InterlockedIncrement(&m_pHeader->Ring[nRing].lWakeSeq);
+	syscall(SYS_futex, &m_pHeader->Ring[nRing].lWakeSeq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// ˯ߣlSeqˣ˻ѹأǰأҪ¼
+//-----------------------------------------------------------------------------
+inline void XShmChannel::Wait(int nRing, LONG lSeq, DWORD dwTimeout)
+{
+#ifdef _WIN32
+	(void)lSeq;
+	::WaitForSingleObject(m_hEvent[nRing], dwTimeout);
+#else
+	timespec ts;
+	ts.tv_sec = dwTimeout / 1000;
+	ts.tv_nsec = (long)(dwTimeout % 1000) * 1000000;
+	syscall(SYS_futex, &m_pHeader->Ring[nRing].lWakeSeq, FUTEX_WAIT, lSeq, &ts, NULL, 0);
+#endif
+}
+
+#endif // !__XSHMCHANNEL_H__
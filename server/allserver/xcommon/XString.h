@@ -0,0 +1,534 @@
+#pragma once
+
+#ifndef __XSTRING_H__
+#define __XSTRING_H__
+
+#include "XMemCache.h"
+
+//-----------------------------------------------------------------------------
+// ַϣFNV-1a
+//-----------------------------------------------------------------------------
+inline unsigned long long XHashString(const char* szStr, unsigned int dwLen)
+{
+	unsigned long long qwHash = 14695981039346656037ULL;
+	for (unsigned int n = 0; n < dwLen; ++n)
+	{
+		qwHash ^= (unsigned char)szStr[n];
+		qwHash *= 1099511628211ULL;
+	}
+	return qwHash;
+}
+
+//-----------------------------------------------------------------------------
+// ֱַӴڶڣĴڴط
+//-----------------------------------------------------------------------------
+class XSmallString
+{
+public:
+	enum { INLINE_SIZE = 23 };	// ŵַβ0
+
+	//-----------------------------------------------------------------------------
+	XSmallString() : m_dwLen(0), m_dwCapacity(INLINE_SIZE)
+	{
+		m_szBuf[0] = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString(const char* szStr) : m_dwLen(0), m_dwCapacity(INLINE_SIZE)
+	{
+		m_szBuf[0] = 0;
+		Assign(szStr, szStr ? (unsigned int)strlen(szStr) : 0);
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString(const char* szStr, unsigned int dwLen) : m_dwLen(0), m_dwCapacity(INLINE_SIZE)
+	{
+		m_szBuf[0] = 0;
+		Assign(szStr, dwLen);
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString(const XSmallString& str) : m_dwLen(0), m_dwCapacity(INLINE_SIZE)
+	{
+		m_szBuf[0] = 0;
+		Assign(str.c_str(), str.Length());
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString(XSmallString&& str) : m_dwLen(0), m_dwCapacity(INLINE_SIZE)
+	{
+		m_szBuf[0] = 0;
+		Swap(str);
+	}
+
+	//-----------------------------------------------------------------------------
+	~XSmallString()
+	{
+		if (!IsInline())
+		{
+			MCFREE(m_pHeap);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString& operator=(const XSmallString& str)
+	{
+		if (this != &str)
+		{
+			Assign(str.c_str(), str.Length());
+		}
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString& operator=(XSmallString&& str)
+	{
+		Swap(str);
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	XSmallString& operator=(const char* szStr)
+	{
+		Assign(szStr, szStr ? (unsigned int)strlen(szStr) : 0);
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	// Դһ֣ŵʱԭmemmoveŲʱ»ƴٻϣ
+	// ɻ壨ڵĻϵģڿ֮ǰһֱ
+	//-----------------------------------------------------------------------------
+	void Assign(const char* szStr, unsigned int dwLen)
+	{
+		if (dwLen <= m_dwCapacity)
+		{
+			char* pBuf = Data();
+			memmove(pBuf, szStr, dwLen);
+			pBuf[dwLen] = 0;
+			m_dwLen = dwLen;
+			return;
+		}
+
+		unsigned int dwCapacity;
+		char* pNew = AllocBuf(dwLen, dwCapacity);
+		if (!pNew)
+		{
+			return;
+		}
+
+		memcpy(pNew, szStr, dwLen);
+		pNew[dwLen] = 0;
+		SetHeap(pNew, dwCapacity);
+		m_dwLen = dwLen;
+	}
+
+	//-----------------------------------------------------------------------------
+	void Append(const char* szStr, unsigned int dwLen)
+	{
+		unsigned int dwNewLen = m_dwLen + dwLen;
+		if (dwNewLen <= m_dwCapacity)
+		{
+			char* pBuf = Data();
+			memmove(pBuf + m_dwLen, szStr, dwLen);
+			pBuf[dwNewLen] = 0;
+			m_dwLen = dwNewLen;
+			return;
+		}
+
+		unsigned int dwCapacity;
+		char* pNew = AllocBuf(dwNewLen, dwCapacity);
+		if (!pNew)
+		{
+			return;
+		}
+
+		memcpy(pNew, c_str(), m_dwLen);
+		memcpy(pNew + m_dwLen, szStr, dwLen);
+		pNew[dwNewLen] = 0;
+		SetHeap(pNew, dwCapacity);
+		m_dwLen = dwNewLen;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ֤dwLenַ
+	//-----------------------------------------------------------------------------
+	bool Reserve(unsigned int dwLen)
+	{
+		if (dwLen <= m_dwCapacity)
+		{
+			return true;
+		}
+
+		unsigned int dwCapacity;
+		char* pNew = AllocBuf(dwLen, dwCapacity);
+		if (!pNew)
+		{
+			return false;
+		}
+
+		memcpy(pNew, c_str(), m_dwLen + 1);
+		SetHeap(pNew, dwCapacity);
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	void Swap(XSmallString& str)
+	{
+		char szTemp[sizeof(m_szBuf)];
+		memcpy(szTemp, m_szBuf, sizeof(m_szBuf));
+		memcpy(m_szBuf, str.m_szBuf, sizeof(m_szBuf));
+		memcpy(str.m_szBuf, szTemp, sizeof(m_szBuf));
+
+		unsigned int dwTemp = m_dwLen; m_dwLen = str.m_dwLen; str.m_dwLen = dwTemp;
+		dwTemp = m_dwCapacity; m_dwCapacity = str.m_dwCapacity; str.m_dwCapacity = dwTemp;
+	}
+
+	//-----------------------------------------------------------------------------
+	const char* c_str() const { return IsInline() ? m_szBuf : m_pHeap; }
+
+	//-----------------------------------------------------------------------------
+	unsigned int Length() const { return m_dwLen; }
+
+	//-----------------------------------------------------------------------------
+	bool Empty() const { return m_dwLen == 0; }
+
+	//-----------------------------------------------------------------------------
+	unsigned long long Hash() const { return XHashString(c_str(), m_dwLen); }
+
+	//-----------------------------------------------------------------------------
+	bool operator==(const XSmallString& str) const
+	{
+		return m_dwLen == str.m_dwLen && memcmp(c_str(), str.c_str(), m_dwLen) == 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	bool operator!=(const XSmallString& str) const { return !(*this == str); }
+
+	//-----------------------------------------------------------------------------
+	bool operator<(const XSmallString& str) const
+	{
+		unsigned int dwLen = m_dwLen < str.m_dwLen ? m_dwLen : str.m_dwLen;
+		int nRet = memcmp(c_str(), str.c_str(), dwLen);
+		return nRet < 0 || (nRet == 0 && m_dwLen < str.m_dwLen);
+	}
+
+private:
+	//-----------------------------------------------------------------------------
+	// ܷdwLenַ»壬ٷ
+	//-----------------------------------------------------------------------------
+	char* AllocBuf(unsigned int dwLen, unsigned int& dwCapacity)
+	{
+		dwCapacity = m_dwCapacity * 2 > dwLen ? m_dwCapacity * 2 : dwLen;
+		return (char*)MCALLOC(dwCapacity + 1);
+	}
+
+	//-----------------------------------------------------------------------------
+	// »壬m_pHeapͶڻ干ÿռ䣬Ҫ֮ǰ
+	//-----------------------------------------------------------------------------
+	void SetHeap(char* pNew, unsigned int dwCapacity)
+	{
+		if (!IsInline())
+		{
+			MCFREE(m_pHeap);
+		}
+		m_pHeap = pNew;
+		m_dwCapacity = dwCapacity;
+	}
+
+	//-----------------------------------------------------------------------------
+	bool IsInline() const { return m_dwCapacity == INLINE_SIZE; }
+
+	//-----------------------------------------------------------------------------
+	char* Data() { return IsInline() ? m_szBuf : m_pHeap; }
+
+private:
+	union
+	{
+		char			m_szBuf[INLINE_SIZE + 1];	// ַ
+		char*			m_pHeap;					// ַINLINE_SIZE
+	};
+	unsigned int		m_dwLen;
+	unsigned int		m_dwCapacity;
+};
+
+
+//-----------------------------------------------------------------------------
+// פַͬݵַõͬһȽֻȽָ
+//-----------------------------------------------------------------------------
+class XInternKey
+{
+public:
+	// פеʵݣƶͷ
+	struct tagEntry
+	{
+		tagEntry*			pNext;
+		unsigned long long	qwHash;
+		unsigned int		dwLen;
+		char				szStr[1];
+	};
+
+	//-----------------------------------------------------------------------------
+	XInternKey() : m_pEntry(nullptr) {}
+
+	//-----------------------------------------------------------------------------
+	explicit XInternKey(const tagEntry* pEntry) : m_pEntry(pEntry) {}
+
+	//-----------------------------------------------------------------------------
+	bool IsValid() const { return m_pEntry != nullptr; }
+
+	//-----------------------------------------------------------------------------
+	const char* c_str() const { return m_pEntry ? m_pEntry->szStr : ""; }
+
+	//-----------------------------------------------------------------------------
+	unsigned int Length() const { return m_pEntry ? m_pEntry->dwLen : 0; }
+
+	//-----------------------------------------------------------------------------
+	unsigned long long Hash() const { return m_pEntry ? m_pEntry->qwHash : 0; }
+
+	//-----------------------------------------------------------------------------
+	bool operator==(const XInternKey& key) const { return m_pEntry == key.m_pEntry; }
+
+	//-----------------------------------------------------------------------------
+	bool operator!=(const XInternKey& key) const { return m_pEntry != key.m_pEntry; }
+
+	//-----------------------------------------------------------------------------
+	// ֻ֤˳ȶֵ
+	//-----------------------------------------------------------------------------
+	bool operator<(const XInternKey& key) const { return m_pEntry < key.m_pEntry; }
+
+	// std::unordered_map
+	struct Hasher
+	{
+		size_t operator()(const XInternKey& key) const { return (size_t)key.Hash(); }
+	};
+
+private:
+	const tagEntry*		m_pEntry;
+};
+
+
+//-----------------------------------------------------------------------------
+// ַפϣֳɶƬÿƬһ
+//-----------------------------------------------------------------------------
+template<typename MutexType = XAtomMutex>
+class XInternTable
+{
+public:
+	enum { SHARD_NUM = 16 };
+
+	//-----------------------------------------------------------------------------
+	XInternTable();
+
+	//-----------------------------------------------------------------------------
+	~XInternTable();
+
+	//-----------------------------------------------------------------------------
+	// פַȶľ
+	//-----------------------------------------------------------------------------
+	XInternKey Intern(const char* szStr, unsigned int dwLen);
+
+	//-----------------------------------------------------------------------------
+	XInternKey Intern(const char* szStr) { return Intern(szStr, (unsigned int)strlen(szStr)); }
+
+	//-----------------------------------------------------------------------------
+	XInternKey Intern(const XSmallString& str) { return Intern(str.c_str(), str.Length()); }
+
+	//-----------------------------------------------------------------------------
+	// ֻңʱЧ
+	//-----------------------------------------------------------------------------
+	XInternKey Find(const char* szStr, unsigned int dwLen);
+
+	//-----------------------------------------------------------------------------
+	unsigned int GetCount();
+
+private:
+	typedef XInternKey::tagEntry tagEntry;
+
+	//-----------------------------------------------------------------------------
+	tagEntry* FindInShard(int nShard, unsigned long long qwHash, const char* szStr, unsigned int dwLen);
+
+	//-----------------------------------------------------------------------------
+	void Grow(int nShard);
+
+private:
+	struct
+	{
+		MutexType		Lock;
+		tagEntry**		ppBucket;
+		unsigned int	dwBucketNum;	// 2
+		unsigned int	dwCount;
+	} m_Shard[SHARD_NUM];
+};
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+XInternTable<MutexType>::XInternTable()
+{
+	for (int n = 0; n < SHARD_NUM; ++n)
+	{
+		m_Shard[n].dwBucketNum = 0;
+		m_Shard[n].dwCount = 0;
+		m_Shard[n].ppBucket = nullptr;
+		Grow(n);	// ʧʱͰΪ0һפʱ
+	}
+}
+
+template<typename MutexType>
+XInternTable<MutexType>::~XInternTable()
+{
+	for (int n = 0; n < SHARD_NUM; ++n)
+	{
+		for (unsigned int i = 0; i < m_Shard[n].dwBucketNum; ++i)
+		{
+			tagEntry* pEntry = m_Shard[n].ppBucket[i];
+			while (pEntry)
+			{
+				tagEntry* pNext = pEntry->pNext;
+				MCFREE(pEntry);
+				pEntry = pNext;
+			}
+		}
+		if (m_Shard[n].ppBucket)
+		{
+			MCFREE(m_Shard[n].ppBucket);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// פ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+XInternKey XInternTable<MutexType>::Intern(const char* szStr, unsigned int dwLen)
+{
+	unsigned long long qwHash = XHashString(szStr, dwLen);
+	int nShard = (int)(qwHash >> 60);	// λѡƬλѡͰ
+
+	m_Shard[nShard].Lock.Lock();
+	if (!m_Shard[nShard].ppBucket)
+	{
+		Grow(nShard);
+		if (!m_Shard[nShard].ppBucket)
+		{
+			m_Shard[nShard].Lock.Unlock();
+			return XInternKey();
+		}
+	}
+
+	tagEntry* pEntry = FindInShard(nShard, qwHash, szStr, dwLen);
+	if (!pEntry)
+	{
+		pEntry = (tagEntry*)MCALLOC(sizeof(tagEntry) + dwLen);
+		if (pEntry)
+		{
+			pEntry->qwHash = qwHash;
+			pEntry->dwLen = dwLen;
+			memcpy(pEntry->szStr, szStr, dwLen);
+			pEntry->szStr[dwLen] = 0;
+
+			unsigned int dwBucket = (unsigned int)qwHash & (m_Shard[nShard].dwBucketNum - 1);
+			pEntry->pNext = m_Shard[nShard].ppBucket[dwBucket];
+			m_Shard[nShard].ppBucket[dwBucket] = pEntry;
+
+			if (++m_Shard[nShard].dwCount > m_Shard[nShard].dwBucketNum)
+			{
+				Grow(nShard);
+			}
+		}
+	}
+	m_Shard[nShard].Lock.Unlock();
+
+	return XInternKey(pEntry);
+}
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+XInternKey XInternTable<MutexType>::Find(const char* szStr, unsigned int dwLen)
+{
+	unsigned long long qwHash = XHashString(szStr, dwLen);
+	int nShard = (int)(qwHash >> 60);
+
+	m_Shard[nShard].Lock.Lock();
+	tagEntry* pEntry = FindInShard(nShard, qwHash, szStr, dwLen);
+	m_Shard[nShard].Lock.Unlock();
+
+	return XInternKey(pEntry);
+}
+
+//-----------------------------------------------------------------------------
+// פַ
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+unsigned int XInternTable<MutexType>::GetCount()
+{
+	unsigned int dwCount = 0;
+	for (int n = 0; n < SHARD_NUM; ++n)
+	{
+		dwCount += m_Shard[n].dwCount;
+	}
+	return dwCount;
+}
+
+//-----------------------------------------------------------------------------
+// ڷƬвң߼
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+typename XInternTable<MutexType>::tagEntry* XInternTable<MutexType>::FindInShard(int nShard, unsigned long long qwHash, const char* szStr, unsigned int dwLen)
+{
+	if (!m_Shard[nShard].ppBucket)
+	{
+		return nullptr;
+	}
+
+	tagEntry* pEntry = m_Shard[nShard].ppBucket[(unsigned int)qwHash & (m_Shard[nShard].dwBucketNum - 1)];
+	while (pEntry)
+	{
+		if (pEntry->qwHash == qwHash && pEntry->dwLen == dwLen && memcmp(pEntry->szStr, szStr, dwLen) == 0)
+		{
+			return pEntry;
+		}
+		pEntry = pEntry->pNext;
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// ͰûͰʱʼ64߼
+//-----------------------------------------------------------------------------
+template<typename MutexType>
+void XInternTable<MutexType>::Grow(int nShard)
+{
+	unsigned int dwNewNum = m_Shard[nShard].dwBucketNum ? m_Shard[nShard].dwBucketNum * 2 : 64;
+	tagEntry** ppNew = (tagEntry**)MCALLOC(sizeof(tagEntry*) * dwNewNum);
+	if (!ppNew)
+	{
+		return;	// ʧֻǱ
+	}
+	ZeroMemory(ppNew, sizeof(tagEntry*) * dwNewNum);
+
+	for (unsigned int i = 0; i < m_Shard[nShard].dwBucketNum; ++i)
+	{
+		tagEntry* pEntry = m_Shard[nShard].ppBucket[i];
+		while (pEntry)
+		{
+			tagEntry* pNext = pEntry->pNext;
+			unsigned int dwBucket = (unsigned int)pEntry->qwHash & (dwNewNum - 1);
+			pEntry->pNext = ppNew[dwBucket];
+			ppNew[dwBucket] = pEntry;
+			pEntry = pNext;
+		}
+	}
+
+	if (m_Shard[nShard].ppBucket)
+	{
+		MCFREE(m_Shard[nShard].ppBucket);
+	}
+	m_Shard[nShard].ppBucket = ppNew;
+	m_Shard[nShard].dwBucketNum = dwNewNum;
+}
+
+#endif // !__XSTRING_H__
@@ -83,6 +83,21 @@
 			tDes.__l[1] = SwapByte32(tSrc.__l[0]);
 			return tDes.__ll;
 		}
+	#elif defined _WIN64
+		// x64VC֧࣬ҲûжWIN32ڽ
+		#include <stdlib.h>
+		inline unsigned short SwapByte16(unsigned short vData)
+		{
+			return _byteswap_ushort(vData);
+		}
+		inline unsigned int SwapByte32(unsigned int vData)
+		{
+			return _byteswap_ulong(vData);
+		}
+		inline unsigned long long SwapByte64(unsigned long long vData)
+		{
+			return _byteswap_uint64(vData);
+		}
 	#elif defined WIN32
 		inline unsigned short SwapByte16(unsigned short vData)
 		{
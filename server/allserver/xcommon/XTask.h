@@ -0,0 +1,210 @@
+#pragma once
+
+#ifndef __XTASK_H__
+#define __XTASK_H__
+
+#include "XMemCache.h"
+
+//-----------------------------------------------------------------------------
+// ЭҪC++20Э֧֣VS2019 16.8 /std:c++latest
+// ֧ʱXCORO_SUPPORTEDΪ0ļκ
+//-----------------------------------------------------------------------------
+#if defined(__cpp_impl_coroutine)
+#	define XCORO_SUPPORTED	1
+#else
+#	define XCORO_SUPPORTED	0
+#endif
+
+#if XCORO_SUPPORTED
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+
+extern XMemCache<XAtomMutex>*	g_pMemCache;
+
+typedef std::coroutine_handle<>	XCoroHandle;
+
+template<typename T> class XTask;
+
+//-----------------------------------------------------------------------------
+// Эpromise֣Э֡ڴط
+//-----------------------------------------------------------------------------
+struct XTaskPromiseBase
+{
+	// ʱлصȴߣûеȴѷԼ
+	struct FinalAwaiter
+	{
+		bool await_ready() noexcept { return false; }
+
+		template<typename Promise>
+		XCoroHandle await_suspend(std::coroutine_handle<Promise> h) noexcept
+		{
+			XTaskPromiseBase& promise = h.promise();
+			if (promise.m_hContinuation)
+			{
+				return promise.m_hContinuation;
+			}
+
+			if (promise.m_bDetached)
+			{
+				h.destroy();
+			}
+			return std::noop_coroutine();
+		}
+
+		void await_resume() noexcept {}
+	};
+
+	std::suspend_always initial_suspend() noexcept { return {}; }
+	FinalAwaiter final_suspend() noexcept { return {}; }
+
+	void unhandled_exception()
+	{
+		m_pException = std::current_exception();
+	}
+
+	void Rethrow()
+	{
+		if (m_pException)
+		{
+			std::rethrow_exception(m_pException);
+		}
+	}
+
+	static void* operator new(size_t stSize)
+	{
+		return MCALLOC(stSize);
+	}
+
+	static void operator delete(void* p)
+	{
+		MCFREE(p);
+	}
+
+	XCoroHandle			m_hContinuation;		// co_awaitЭ
+	std::exception_ptr	m_pException;
+	bool				m_bDetached = false;	// ûеȴߣʱԼ
+};
+
+//-----------------------------------------------------------------------------
+// зֵpromise
+//-----------------------------------------------------------------------------
+template<typename T>
+struct XTaskPromise : XTaskPromiseBase
+{
+	XTask<T> get_return_object();
+
+	void return_value(T value)
+	{
+		m_Value.emplace(std::move(value));
+	}
+
+	T GetResult()
+	{
+		Rethrow();
+		return std::move(*m_Value);
+	}
+
+	std::optional<T>	m_Value;
+};
+
+//-----------------------------------------------------------------------------
+// ޷ֵpromise
+//-----------------------------------------------------------------------------
+template<>
+struct XTaskPromise<void> : XTaskPromiseBase
+{
+	XTask<void> get_return_object();
+
+	void return_void()
+	{
+	}
+
+	void GetResult()
+	{
+		Rethrow();
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Э񣬴Уco_awaitDetachʱſʼ
+//-----------------------------------------------------------------------------
+template<typename T = void>
+class XTask
+{
+public:
+	typedef XTaskPromise<T>						promise_type;
+	typedef std::coroutine_handle<promise_type>	handle_type;
+
+	//-----------------------------------------------------------------------------
+	// ȴɣʱֱл
+	//-----------------------------------------------------------------------------
+	bool await_ready() const noexcept
+	{
+		return !m_h || m_h.done();
+	}
+
+	XCoroHandle await_suspend(XCoroHandle hCaller) noexcept
+	{
+		m_h.promise().m_hContinuation = hCaller;
+		return m_h;
+	}
+
+	T await_resume()
+	{
+		return m_h.promise().GetResult();
+	}
+
+	//-----------------------------------------------------------------------------
+	// ȴڵǰ߳̿ʼУԼ
+	//-----------------------------------------------------------------------------
+	void Detach()
+	{
+		handle_type h = m_h;
+		m_h = nullptr;
+		h.promise().m_bDetached = true;
+		h.resume();
+	}
+
+	//-----------------------------------------------------------------------------
+	explicit XTask(handle_type h) : m_h(h)
+	{
+	}
+
+	XTask(XTask&& other) noexcept : m_h(other.m_h)
+	{
+		other.m_h = nullptr;
+	}
+
+	~XTask()
+	{
+		if (m_h)
+		{
+			m_h.destroy();
+		}
+	}
+
+private:
+	XTask(const XTask&) = delete;
+	XTask& operator=(const XTask&) = delete;
+
+	handle_type		m_h;
+};
+
+//-----------------------------------------------------------------------------
+template<typename T>
+XTask<T> XTaskPromise<T>::get_return_object()
+{
+	return XTask<T>(std::coroutine_handle<XTaskPromise<T>>::from_promise(*this));
+}
+
+//-----------------------------------------------------------------------------
+inline XTask<void> XTaskPromise<void>::get_return_object()
+{
+	return XTask<void>(std::coroutine_handle<XTaskPromise<void>>::from_promise(*this));
+}
+
+#endif // XCORO_SUPPORTED
+
+#endif // !__XTASK_H__
@@ -0,0 +1,457 @@
+#pragma once
+
+#ifndef __XTRACE_H__
+#define __XTRACE_H__
+
+#include "XMutex.h"
+#include <atomic>
+#include <list>
+#include <vector>
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#else
+#	include <x86intrin.h>
+#	include <time.h>
+#	include <unistd.h>
+#	include <sys/syscall.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// ߳¼
+//
+// ÿ߳дԼĻλ壬ʱУ׼TSC
+// ̵߳һμ¼¼ʱŷ䣬߳˳ʱͷţDumpֻе߳
+// Dumpʱϲ̵߳Ļ壬Chrome/PerfettoԴ򿪵json
+// NO_XTRACEʱкΪ
+//-----------------------------------------------------------------------------
+#ifdef NO_XTRACE
+#	define XTRACE_SCOPE(name)
+#	define XTRACE_SCOPE_ARG(name, arg)
+#	define XTRACE_INSTANT(name)
+#	define XTRACE_THREAD_NAME(name)
+#	define XTRACE_LOCK(lock, name)		(lock).Lock()
+#else
+#	define XTRACE_CAT2(a, b)			a##b
+#	define XTRACE_CAT(a, b)				XTRACE_CAT2(a, b)
+#	define XTRACE_SCOPE(name)			XTraceScope XTRACE_CAT(__xtrace_, __LINE__)(name, 0)
+#	define XTRACE_SCOPE_ARG(name, arg)	XTraceScope XTRACE_CAT(__xtrace_, __LINE__)(name, (unsigned int)(arg))
+#	define XTRACE_INSTANT(name)			XTrace::Instant(name)
+#	define XTRACE_THREAD_NAME(name)		XTrace::SetThreadName(name)
+	// ֻòʱż¼ȴʱ
+#	define XTRACE_LOCK(lock, name)		do { if (!(lock).TryLock()) { XTRACE_SCOPE(name); (lock).Lock(); } } while (0)
+#endif
+
+//-----------------------------------------------------------------------------
+// ¼nameǳַ
+//-----------------------------------------------------------------------------
+struct tagTraceEvent
+{
+	const char*			szName;
+	unsigned long long	qwBegin;
+	unsigned long long	qwEnd;		// qwBeginʱΪ˲ʱ¼
+	unsigned int		dwArg;
+	unsigned int		dwPad;
+};
+
+//-----------------------------------------------------------------------------
+// ÿ߳һĻλ壬ֻ߳д
+//-----------------------------------------------------------------------------
+struct XTraceRing
+{
+	enum { RING_SIZE = 8192 };	// 2
+
+	tagTraceEvent						Events[RING_SIZE];
+	std::atomic<unsigned long long>		qwHead;			// д¼
+	unsigned int						dwTid;
+	char								szThreadName[32];
+	XTraceRing*							pNext;
+
+	XTraceRing() : qwHead(0), dwTid(0), pNext(nullptr) { szThreadName[0] = 0; }
+};
+
+//-----------------------------------------------------------------------------
+// ÿ̵߳ĸ״̬߳ڻǰҲȼ
+//-----------------------------------------------------------------------------
+struct XTraceThread
+{
+	XTraceRing*		pRing;
+	char			szThreadName[32];
+
+	XTraceThread() : pRing(nullptr) { szThreadName[0] = 0; }
+	~XTraceThread();
+};
+
+//-----------------------------------------------------------------------------
+// ٹȫΪ̬
+//-----------------------------------------------------------------------------
+class XTrace
+{
+public:
+	//-----------------------------------------------------------------------------
+	static void SetEnable(bool bEnable)
+	{
+		if (bEnable)
+		{
+			GetTicksPerUs();	// У׼Ҫڵһμ¼ʱУ׼
+		}
+		IsEnabledRef().store(bEnable, std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	static bool IsEnabled()
+	{
+		return IsEnabledRef().load(std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	static unsigned long long Now()
+	{
+		return __rdtsc();
+	}
+
+	//-----------------------------------------------------------------------------
+	// д뵱ǰ̵߳Ļ壬˸ɵ
+	//-----------------------------------------------------------------------------
+	static void Record(const char* szName, unsigned long long qwBegin, unsigned long long qwEnd, unsigned int dwArg)
+	{
+		if (!IsEnabled())
+		{
+			return;
+		}
+
+		XTraceRing* pRing = GetRing();
+		if (!pRing)
+		{
+			return;
+		}
+
+		unsigned long long qwHead = pRing->qwHead.load(std::memory_order_relaxed);
+		tagTraceEvent& event = pRing->Events[qwHead & (XTraceRing::RING_SIZE - 1)];
+		event.szName = szName;
+		event.qwBegin = qwBegin;
+		event.qwEnd = qwEnd;
+		event.dwArg = dwArg;
+		pRing->qwHead.store(qwHead + 1, std::memory_order_release);
+	}
+
+	//-----------------------------------------------------------------------------
+	static void Instant(const char* szName)
+	{
+		if (IsEnabled())
+		{
+			unsigned long long qwNow = Now();
+			Record(szName, qwNow, qwNow, 0);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	// ֻ֣仺
+	//-----------------------------------------------------------------------------
+	static void SetThreadName(const char* szName)
+	{
+		XTraceThread& thread = GetThread();
+		strncpy(thread.szThreadName, szName, sizeof(thread.szThreadName) - 1);
+		thread.szThreadName[sizeof(thread.szThreadName) - 1] = 0;
+
+		if (thread.pRing)
+		{
+			GetLock().Lock();	// Dump
+			memcpy(thread.pRing->szThreadName, thread.szThreadName, sizeof(thread.szThreadName));
+			GetLock().Unlock();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	// ϲ̵߳Ļ壬дChrome traceʽд¼ʧܷ-1
+	//-----------------------------------------------------------------------------
+	static int Dump(const char* szFile);
+
+private:
+	//-----------------------------------------------------------------------------
+	static std::atomic<bool>& IsEnabledRef()
+	{
+		static std::atomic<bool> s_bEnabled(false);
+		return s_bEnabled;
+	}
+
+	//-----------------------------------------------------------------------------
+	static XMutex& GetLock()
+	{
+		static XMutex s_Lock;
+		return s_Lock;
+	}
+
+	//-----------------------------------------------------------------------------
+	static XTraceRing*& GetRingList()
+	{
+		static XTraceRing* s_pList = nullptr;
+		return s_pList;
+	}
+
+	//-----------------------------------------------------------------------------
+	static XTraceThread& GetThread()
+	{
+		static thread_local XTraceThread s_Thread;
+		return s_Thread;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ǰ̵߳Ļ壬һμ¼ʱǼ
+	//-----------------------------------------------------------------------------
+	static XTraceRing* GetRing()
+	{
+		XTraceThread& thread = GetThread();
+		if (!thread.pRing)
+		{
+			XTraceRing* pRing = new XTraceRing;
+			pRing->dwTid = GetThreadId();
+			memcpy(pRing->szThreadName, thread.szThreadName, sizeof(thread.szThreadName));
+
+			GetLock().Lock();
+			pRing->pNext = GetRingList();
+			GetRingList() = pRing;
+			GetLock().Unlock();
+
+			thread.pRing = pRing;
+		}
+		return thread.pRing;
+	}
+
+	//-----------------------------------------------------------------------------
+	// ߳˳ʱժ²ͷţDumpڼͷŵĻ
+	//-----------------------------------------------------------------------------
+	static void ReleaseRing(XTraceRing* pRing)
+	{
+		GetLock().Lock();
+		for (XTraceRing** ppRing = &GetRingList(); *ppRing; ppRing = &(*ppRing)->pNext)
+		{
+			if (*ppRing == pRing)
+			{
+				*ppRing = pRing->pNext;
+				break;
+			}
+		}
+		GetLock().Unlock();
+
+		delete pRing;
+	}
+
+	friend struct XTraceThread;
+
+	//-----------------------------------------------------------------------------
+	static unsigned int GetThreadId()
+	{
+#ifdef _WIN32
+		return (unsigned int)::GetCurrentThreadId();
+#else
+		return (unsigned int)syscall(SYS_gettid);
+#endif
+	}
+
+	//-----------------------------------------------------------------------------
+	static unsigned int GetProcessId()
+	{
+#ifdef _WIN32
+		return (unsigned int)::GetCurrentProcessId();
+#else
+		return (unsigned int)getpid();
+#endif
+	}
+
+	//-----------------------------------------------------------------------------
+	// ϵͳʱӣ΢
+	//-----------------------------------------------------------------------------
+	static double GetSystemUs()
+	{
+#ifdef _WIN32
+		LARGE_INTEGER freq, count;
+		::QueryPerformanceFrequency(&freq);
+		::QueryPerformanceCounter(&count);
+		return (double)count.QuadPart * 1000000.0 / (double)freq.QuadPart;
+#else
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (double)ts.tv_sec * 1000000.0 + (double)ts.tv_nsec / 1000.0;
+#endif
+	}
+
+	//-----------------------------------------------------------------------------
+	// ϵͳʱУ׼TSCƵʣֻһ
+	//-----------------------------------------------------------------------------
+	static double GetTicksPerUs()
+	{
+		struct tagCalibrate
+		{
+			double fTicksPerUs;
+			tagCalibrate()
+			{
+				double fBeginUs = GetSystemUs();
+				unsigned long long qwBegin = __rdtsc();
+				double fEndUs = fBeginUs;
+				while (fEndUs - fBeginUs < 10000.0)	// 10ms
+				{
+					fEndUs = GetSystemUs();
+				}
+				unsigned long long qwEnd = __rdtsc();
+				fTicksPerUs = (double)(qwEnd - qwBegin) / (fEndUs - fBeginUs);
+			}
+		};
+		static tagCalibrate s_Calibrate;
+		return s_Calibrate.fTicksPerUs;
+	}
+};
+
+//-----------------------------------------------------------------------------
+inline XTraceThread::~XTraceThread()
+{
+	if (pRing)
+	{
+		XTrace::ReleaseRing(pRing);
+		pRing = nullptr;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ¼
+//-----------------------------------------------------------------------------
+class XTraceScope
+{
+public:
+	XTraceScope(const char* szName, unsigned int dwArg)
+		: m_szName(szName)
+		, m_dwArg(dwArg)
+		, m_qwBegin(XTrace::IsEnabled() ? XTrace::Now() : 0)
+	{
+	}
+
+	~XTraceScope()
+	{
+		if (m_qwBegin)
+		{
+			XTrace::Record(m_szName, m_qwBegin, XTrace::Now(), m_dwArg);
+		}
+	}
+
+private:
+	const char*			m_szName;
+	unsigned int		m_dwArg;
+	unsigned long long	m_qwBegin;
+};
+
+//-----------------------------------------------------------------------------
+// 
+//-----------------------------------------------------------------------------
+inline int XTrace::Dump(const char* szFile)
+{
+	struct tagThreadEvents
+	{
+		unsigned int				dwTid;
+		char						szThreadName[32];
+		std::vector<tagTraceEvent>	vecEvent;
+	};
+
+	// ȰѸ̵߳Ļ忽д̲߳ͣ
+	// ڼ߳˳ʱҪȿͷŻ
+	static const unsigned long long RING_SIZE = XTraceRing::RING_SIZE;
+	std::list<tagThreadEvents> listThread;
+	unsigned long long qwBase = ~0ULL;	// ̹߳ʱΪ0
+
+	GetLock().Lock();
+	for (XTraceRing* pRing = GetRingList(); pRing; pRing = pRing->pNext)
+	{
+		listThread.push_back(tagThreadEvents());
+		tagThreadEvents& thread = listThread.back();
+		thread.dwTid = pRing->dwTid;
+		memcpy(thread.szThreadName, pRing->szThreadName, sizeof(thread.szThreadName));
+
+		unsigned long long qwHead = pRing->qwHead.load(std::memory_order_acquire);
+		unsigned long long qwFirst = qwHead > RING_SIZE ? qwHead - RING_SIZE : 0;
+		thread.vecEvent.reserve((size_t)(qwHead - qwFirst));
+		for (unsigned long long n = qwFirst; n < qwHead; ++n)
+		{
+			thread.vecEvent.push_back(pRing->Events[n & (RING_SIZE - 1)]);
+		}
+
+		// ĶŵضqwHead֮
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// д߳дqwNewHead¼ռõǵqwNewHead - RING_SIZEλã
+		// ŲqwNewHead - RING_SIZE¼ѱǻڸǣ
+		unsigned long long qwNewHead = pRing->qwHead.load(std::memory_order_relaxed);
+		if (qwNewHead + 1 > qwFirst + RING_SIZE)
+		{
+			unsigned long long qwLost = qwNewHead + 1 - RING_SIZE - qwFirst;
+			if (qwLost > thread.vecEvent.size())
+			{
+				qwLost = thread.vecEvent.size();
+			}
+			thread.vecEvent.erase(thread.vecEvent.begin(), thread.vecEvent.begin() + (size_t)qwLost);
+		}
+
+		for (size_t n = 0; n < thread.vecEvent.size(); ++n)
+		{
+			if (thread.vecEvent[n].qwBegin < qwBase)
+			{
+				qwBase = thread.vecEvent[n].qwBegin;
+			}
+		}
+	}
+	GetLock().Unlock();
+
+	FILE* fp = fopen(szFile, "w");
+	if (!fp)
+	{
+		return -1;
+	}
+
+	double fTicksPerUs = GetTicksPerUs();
+	unsigned int dwPid = GetProcessId();
+	int nCount = 0;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (std::list<tagThreadEvents>::iterator it = listThread.begin(); it != listThread.end(); ++it)
+	{
+		unsigned int dwTid = it->dwTid;
+		if (it->szThreadName[0])
+		{
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+				nCount ? ",\n" : "", dwPid, dwTid, it->szThreadName);
+			++nCount;
+		}
+
+		for (size_t n = 0; n < it->vecEvent.size(); ++n)
+		{
+			const tagTraceEvent& event = it->vecEvent[n];
+			double fTs = (double)(event.qwBegin - qwBase) / fTicksPerUs;
+
+			fprintf(fp, "%s{\"name\":\"", nCount ? ",\n" : "");
+			for (const char* p = event.szName; p && *p; ++p)
+			{
+				if (*p == '"' || *p == '\\')
+				{
+					fputc('\\', fp);
+				}
+				fputc(*p, fp);
+			}
+
+			if (event.qwEnd == event.qwBegin)
+			{
+				fprintf(fp, "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u}", fTs, dwPid, dwTid);
+			}
+			else
+			{
+				double fDur = (double)(event.qwEnd - event.qwBegin) / fTicksPerUs;
+				fprintf(fp, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"arg\":%u}}",
+					fTs, fDur, dwPid, dwTid, event.dwArg);
+			}
+			++nCount;
+		}
+	}
+	fprintf(fp, "\n]}\n");
+	fclose(fp);
+
+	return nCount;
+}
+
+#endif // !__XTRACE_H__
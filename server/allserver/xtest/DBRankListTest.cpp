@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "DBRankList.h"
+#include "xtest.h"
+
+//-----------------------------------------------------------------------------
+// ߵǰͬIDСǰºθű
+//-----------------------------------------------------------------------------
+XTEST(DBRankList_UpdateAndRank)
+{
+	DBRankList list;
+	for (unsigned long long qwID = 1; qwID <= 100; ++qwID)
+	{
+		XCHECK(list.Update(qwID, (long long)(qwID % 10)));
+	}
+	XCHECK(list.GetCount() == 100);
+
+	// 99,19...99IDСǰ
+	XCHECK(list.GetRank(9) == 1);
+	XCHECK(list.GetRank(99) == 10);
+	XCHECK(list.GetRank(10) == 91);
+	XCHECK(list.GetRank(1000) == 0);
+
+	long long llScore = 0;
+	XCHECK(list.GetScore(19, llScore) && llScore == 9);
+
+	XCHECK(list.Update(10, 100));
+	XCHECK(list.GetRank(10) == 1);
+	XCHECK(list.GetRank(9) == 2);
+	XCHECK(list.GetCount() == 100);
+
+	XCHECK(list.Remove(10));
+	XCHECK(!list.Remove(10));
+	XCHECK(list.GetRank(10) == 0);
+	XCHECK(list.GetRank(9) == 1);
+	XCHECK(list.GetCount() == 99);
+}
+
+//-----------------------------------------------------------------------------
+// ȡǰĳǰԽʱص
+//-----------------------------------------------------------------------------
+XTEST(DBRankList_TopAndAround)
+{
+	DBRankList list;
+	for (unsigned long long qwID = 1; qwID <= 50; ++qwID)
+	{
+		list.Update(qwID, (long long)qwID * 10);
+	}
+
+	tagRankItem items[64];
+	int nNum = list.GetTop(3, items);
+	XCHECK(nNum == 3);
+	XCHECK(items[0].qwID == 50 && items[0].nRank == 1 && items[0].llScore == 500);
+	XCHECK(items[2].qwID == 48 && items[2].nRank == 3);
+
+	nNum = list.GetAround(10, 2, items);
+	XCHECK(nNum == 5);
+	XCHECK(items[0].nRank == 8 && items[4].nRank == 12);
+	XCHECK(items[2].qwID == 41);
+
+	nNum = list.GetAround(2, 3, items);
+	XCHECK(nNum == 5);
+	XCHECK(items[0].nRank == 1 && items[4].nRank == 5);
+
+	nNum = list.GetAround(49, 3, items);
+	XCHECK(nNum == 5);
+	XCHECK(items[0].nRank == 46 && items[4].nRank == 50);
+
+	// 뾶ʱ෵ȫ
+	nNum = list.GetAround(25, INT_MAX, items);
+	XCHECK(nNum == 50);
+	XCHECK(items[0].nRank == 1 && items[49].nRank == 50);
+	XCHECK(list.GetAround(INT_MAX, INT_MAX, items) == 0);
+
+	XCHECK(list.GetAround(0, 3, items) == 0);
+	XCHECK(list.GetAround(3, -1, items) == 0);
+}
+
+//-----------------------------------------------------------------------------
+// 㹻Ľڵ㴥ϣݣݺܰIDҵ
+//-----------------------------------------------------------------------------
+XTEST(DBRankList_HashGrow)
+{
+	DBRankList list;
+	for (unsigned long long qwID = 1; qwID <= 5000; ++qwID)
+	{
+		list.Update(qwID * 7919, (long long)qwID);
+	}
+	XCHECK(list.GetCount() == 5000);
+
+	bool bOk = true;
+	for (unsigned long long qwID = 1; qwID <= 5000; ++qwID)
+	{
+		bOk = bOk && list.GetRank(qwID * 7919) == (int)(5001 - qwID);
+	}
+	XCHECK(bOk);
+}
@@ -0,0 +1,231 @@
+#include "stdafx.h"
+#include "DBStore.h"
+#include "XRecordDelta.h"
+#include "xtest.h"
+
+#if XCORO_SUPPORTED
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#define DBSTORE_TEST_FILE	"xtest_dbstore.dat"
+
+namespace
+{
+	enum { EPF_Level, EPF_Name, EPF_Gold };
+	typedef XRecordSchema<
+		XFixed<unsigned short>,		// EPF_Level
+		XBytes<8>,					// EPF_Name
+		XVarint<long long>			// EPF_Gold
+	> tagPatchSchema;
+	typedef XRecordDelta<tagPatchSchema> tagPatchDelta;
+}
+
+//-----------------------------------------------------------------------------
+// ڶ˿߳һЭ̣
+//-----------------------------------------------------------------------------
+static XTask<void> DBStoreTestTask(XTask<void> task, std::atomic<bool>* pDone)
+{
+	co_await task;
+	pDone->store(true);
+}
+
+static void DBStoreTestRun(XIoPort& port, XTask<void> task)
+{
+	std::atomic<bool> bDone(false);
+	std::thread t(&XIoPort::Run, &port);
+	DBStoreTestTask(std::move(task), &bDone).Detach();
+	while (!bDone.load())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	port.Stop();
+	t.join();
+}
+
+//-----------------------------------------------------------------------------
+static XTask<void> DBStoreTestPut(DBStore* pStore, unsigned long long qwKey, const char* szValue)
+{
+	bool bOK = co_await pStore->Put(qwKey, szValue, (DWORD)strlen(szValue));
+	XCHECK(bOK);
+}
+
+static XTask<void> DBStoreTestGet(DBStore* pStore, unsigned long long qwKey, const char* szValue)
+{
+	std::string strValue;
+	bool bOK = co_await pStore->Get(qwKey, strValue);
+	XCHECK(bOK);
+	XCHECK(strValue == szValue);
+}
+
+static XTask<void> DBStoreTestGetAll(DBStore* pStore)
+{
+	co_await DBStoreTestGet(pStore, 1, "alpha");
+	co_await DBStoreTestGet(pStore, 2, "beta");
+	co_await DBStoreTestGet(pStore, 3, "gamma");
+}
+
+//-----------------------------------------------------------------------------
+static void DBStoreTestScan(void* pParam, unsigned long long qwKey, const std::string& strValue)
+{
+	std::string& strAll = *(std::string*)pParam;
+	strAll += (char)('0' + qwKey);
+	strAll += strValue;
+}
+
+//-----------------------------------------------------------------------------
+static void DBStoreTestRemove()
+{
+	remove(DBSTORE_TEST_FILE);
+	remove(DBSTORE_TEST_FILE ".bloom");
+}
+
+//-----------------------------------------------------------------------------
+// βдһļ¼ڴʱص֮׷ӵļ¼ٴδ򿪻ܶɨҲɨ
+//-----------------------------------------------------------------------------
+XTEST(DBStore_TornTail)
+{
+	DBStoreTestRemove();
+
+	// ¼ٽһֻдͷһݵ
+	FILE* fp = fopen(DBSTORE_TEST_FILE, "wb");
+	XCHECK(fp != nullptr);
+	if (fp == nullptr)
+	{
+		return;
+	}
+	const char* szValues[] = { "alpha", "beta" };
+	for (int n = 0; n < 2; ++n)
+	{
+		unsigned long long qwKey = n + 1;
+		DWORD dwLen = (DWORD)strlen(szValues[n]);
+		fwrite(&qwKey, sizeof(qwKey), 1, fp);
+		fwrite(&dwLen, sizeof(dwLen), 1, fp);
+		fwrite(szValues[n], dwLen, 1, fp);
+	}
+	unsigned long long qwTornKey = 99;
+	DWORD dwTornLen = 100;
+	fwrite(&qwTornKey, sizeof(qwTornKey), 1, fp);
+	fwrite(&dwTornLen, sizeof(dwTornLen), 1, fp);
+	fwrite("xyz", 3, 1, fp);
+	fclose(fp);
+
+	{
+		XIoPort port;
+		XCHECK(port.Create());
+		DBStore store;
+		XCHECK(store.Open(&port, DBSTORE_TEST_FILE, 16, 1));
+		XCHECK(store.GetCount() == 2);
+		DBStoreTestRun(port, DBStoreTestPut(&store, 3, "gamma"));
+		store.Close();
+	}
+
+	{
+		XIoPort port;
+		XCHECK(port.Create());
+		DBStore store;
+		XCHECK(store.Open(&port, DBSTORE_TEST_FILE, 16, 1));
+		XCHECK(store.GetCount() == 3);
+		DBStoreTestRun(port, DBStoreTestGetAll(&store));
+
+		// д˳ÿkeyһ
+		std::string strAll;
+		XCHECK(store.Scan(&DBStoreTestScan, &strAll));
+		XCHECK(strAll == "1alpha2beta3gamma");
+		store.Close();
+	}
+
+	DBStoreTestRemove();
+}
+
+//-----------------------------------------------------------------------------
+static XTask<void> DBStoreTestPatchOne(DBStore* pStore, long long llGold, int* pDone)
+{
+	XRecordDeltaWriter<tagPatchSchema> delta;
+	delta.Set<EPF_Gold>(llGold);
+	delta.Finish();
+	bool bOK = co_await pStore->Patch(1, &tagPatchDelta::Patch, tagPatchSchema::MAX_SIZE, delta.GetData(), delta.GetSize());
+	XCHECK(bOK);
+	++*pDone;
+}
+
+static XTask<void> DBStoreTestPatchAll(XIoPort* pPort, DBStore* pStore)
+{
+	XRecordWriter<tagPatchSchema> writer;
+	writer.Set<EPF_Level>(7);
+	writer.Set<EPF_Name>("alice");
+	writer.Set<EPF_Gold>(5);
+	unsigned int dwSize = writer.Finish();
+	XCHECK(co_await pStore->Put(1, writer.GetData(), dwSize));
+
+	// ͬһkeyͬʱ޸İ˳һһЧ
+	int nDone = 0;
+	for (int n = 1; n <= 20; ++n)
+	{
+		DBStoreTestPatchOne(pStore, n * 1000000000LL, &nDone).Detach();
+	}
+	while (nDone < 20)
+	{
+		co_await pPort->Schedule();
+	}
+
+	std::string strValue;
+	XCHECK(co_await pStore->Get(1, strValue));
+	XRecordView<tagPatchSchema> view(strValue.data(), (unsigned int)strValue.size());
+	XCHECK(view.IsValid());
+	XCHECK(view.Get<EPF_Level>() == 7);
+	XCHECK(strcmp(view.Get<EPF_Name>(), "alice") == 0);
+	XCHECK(view.Get<EPF_Gold>() == 20000000000LL);
+
+	// ڵļ¼ͻĲ첻
+	XRecordDeltaWriter<tagPatchSchema> delta;
+	delta.Set<EPF_Level>(8);
+	delta.Finish();
+	XCHECK(!(co_await pStore->Patch(2, &tagPatchDelta::Patch, tagPatchSchema::MAX_SIZE, delta.GetData(), delta.GetSize())));
+	XCHECK(!(co_await pStore->Patch(1, &tagPatchDelta::Patch, tagPatchSchema::MAX_SIZE, delta.GetData(), 3)));
+
+	std::string strAfter;
+	XCHECK(co_await pStore->Get(1, strAfter));
+	XCHECK(strAfter == strValue);
+}
+
+static XTask<void> DBStoreTestPatchReload(DBStore* pStore)
+{
+	std::string strValue;
+	XCHECK(co_await pStore->Get(1, strValue));
+	XRecordView<tagPatchSchema> view(strValue.data(), (unsigned int)strValue.size());
+	XCHECK(view.IsValid() && view.Get<EPF_Level>() == 7 && view.Get<EPF_Gold>() == 20000000000LL);
+}
+
+//-----------------------------------------------------------------------------
+// ޸ļ¼޸Ĳาǣļ¼´򿪻
+//-----------------------------------------------------------------------------
+XTEST(DBStore_Patch)
+{
+	DBStoreTestRemove();
+
+	{
+		XIoPort port;
+		XCHECK(port.Create());
+		DBStore store;
+		XCHECK(store.Open(&port, DBSTORE_TEST_FILE, 16, 1));
+		DBStoreTestRun(port, DBStoreTestPatchAll(&port, &store));
+		store.Close();
+	}
+
+	{
+		XIoPort port;
+		XCHECK(port.Create());
+		DBStore store;
+		XCHECK(store.Open(&port, DBSTORE_TEST_FILE, 16, 1));
+		XCHECK(store.GetCount() == 1);
+		DBStoreTestRun(port, DBStoreTestPatchReload(&store));
+		store.Close();
+	}
+
+	DBStoreTestRemove();
+}
+
+#endif // XCORO_SUPPORTED
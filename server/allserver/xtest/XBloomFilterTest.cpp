@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "XBloomFilter.h"
+#include "xtest.h"
+
+//-----------------------------------------------------------------------------
+// ӹһУûӹÿkey 12λԤڸ
+//-----------------------------------------------------------------------------
+XTEST(XBloomFilter_NoFalseNegative)
+{
+	XBloomFilter* pFilter = XBloomFilter::Create(10000);
+	XCHECK(pFilter != nullptr);
+	if (pFilter == nullptr)
+	{
+		return;
+	}
+	XCHECK(pFilter->GetCapacity() >= 10000);
+
+	for (unsigned long long qwKey = 0; qwKey < 10000; ++qwKey)
+	{
+		pFilter->Add(qwKey * 0x9E3779B97F4A7C15ULL);
+	}
+
+	bool bAll = true;
+	for (unsigned long long qwKey = 0; qwKey < 10000; ++qwKey)
+	{
+		bAll = bAll && pFilter->MayContain(qwKey * 0x9E3779B97F4A7C15ULL);
+	}
+	XCHECK(bAll);
+
+	int nFalse = 0;
+	for (unsigned long long qwKey = 1; qwKey <= 100000; ++qwKey)
+	{
+		nFalse += pFilter->MayContain(qwKey * 0x9E3779B97F4A7C15ULL + 1) ? 1 : 0;
+	}
+	XCHECK(nFalse < 2000);	// 2%ԤԼ0.5%
+
+	XBloomFilter::Destroy(pFilter);
+}
+
+//-----------------------------------------------------------------------------
+// ٶһ£ͷԵľܾ
+//-----------------------------------------------------------------------------
+XTEST(XBloomFilter_SaveLoad)
+{
+	XBloomFilter* pFilter = XBloomFilter::Create(1000);
+	for (unsigned long long qwKey = 1; qwKey <= 1000; ++qwKey)
+	{
+		pFilter->Add(qwKey);
+	}
+
+	FILE* fp = tmpfile();
+	XCHECK(fp != nullptr);
+	if (fp == nullptr)
+	{
+		XBloomFilter::Destroy(pFilter);
+		return;
+	}
+	XCHECK(pFilter->Save(fp));
+
+	rewind(fp);
+	XBloomFilter* pLoad = XBloomFilter::Load(fp);
+	XCHECK(pLoad != nullptr);
+	if (pLoad)
+	{
+		XCHECK(pLoad->GetCapacity() == pFilter->GetCapacity());
+		bool bSame = true;
+		for (unsigned long long qwKey = 1; qwKey <= 5000; ++qwKey)
+		{
+			bSame = bSame && pLoad->MayContain(qwKey) == pFilter->MayContain(qwKey);
+		}
+		XCHECK(bSame);
+		XBloomFilter::Destroy(pLoad);
+	}
+
+	// Բ
+	rewind(fp);
+	unsigned int dwHead[2];
+	XCHECK(fread(dwHead, sizeof(dwHead), 1, fp) == 1);
+	unsigned int dwBad[2] = { dwHead[0], dwHead[1] + 1 };
+	rewind(fp);
+	fwrite(dwBad, sizeof(dwBad), 1, fp);
+	rewind(fp);
+	XCHECK(XBloomFilter::Load(fp) == nullptr);
+	fclose(fp);
+
+	// ͷԵݲȫ
+	fp = tmpfile();
+	if (fp)
+	{
+		char szBlock[32] = { 0 };
+		fwrite(dwHead, sizeof(dwHead), 1, fp);
+		fwrite(szBlock, sizeof(szBlock), 1, fp);
+		rewind(fp);
+		XCHECK(XBloomFilter::Load(fp) == nullptr);
+		fclose(fp);
+	}
+
+	XBloomFilter::Destroy(pFilter);
+}
@@ -0,0 +1,97 @@
+#include "stdafx.h"
+#include "XEpoch.h"
+#include "xtest.h"
+#include <thread>
+
+//-----------------------------------------------------------------------------
+// ûжʱFlushܻȫ
+//-----------------------------------------------------------------------------
+XTEST(XEpoch_FlushWithoutReaders)
+{
+	XEpoch::Flush();
+
+	for (int n = 0; n < 10; ++n)
+	{
+		XEpoch::Retire(MCALLOC(32));
+	}
+	XCHECK(XEpoch::Flush() == 10);
+	XCHECK(XEpoch::Flush() == 0);
+}
+
+//-----------------------------------------------------------------------------
+// ߳û뿪ǰգ뿪
+// Σָ뱣Ľڵ㲻
+//-----------------------------------------------------------------------------
+XTEST(XEpoch_ReaderAndHazard)
+{
+	XEpoch::Flush();
+
+	LONG volatile lState = 0;	// 1ѽ2뿪
+	std::thread reader([&]()
+	{
+		XEpochGuard guard;
+		::InterlockedExchange(&lState, 1);
+		while (::InterlockedCompareExchange(&lState, 0, 0) != 2)
+		{
+			Sleep(1);
+		}
+	});
+	while (::InterlockedCompareExchange(&lState, 0, 0) != 1)
+	{
+		Sleep(1);
+	}
+
+	XEpoch::Retire(MCALLOC(32));
+	XCHECK(XEpoch::Flush() == 0);
+
+	::InterlockedExchange(&lState, 2);
+	reader.join();
+	XCHECK(XEpoch::Flush() == 1);
+
+	void* volatile pNode = MCALLOC(32);
+	void* pProtected = XEpoch::Protect(0, &pNode);
+	XCHECK(pProtected == pNode);
+	XEpoch::Retire(pProtected);
+	XCHECK(XEpoch::Flush() == 0);
+
+	XEpoch::Release(0);
+	XCHECK(XEpoch::Flush() == 1);
+}
+
+//-----------------------------------------------------------------------------
+// ˳̻߳ղ˵Ľڵ㣬ɱ߳Flush
+//-----------------------------------------------------------------------------
+XTEST(XEpoch_OrphansAfterThreadExit)
+{
+	XEpoch::Flush();
+
+	LONG volatile lState = 0;
+	std::thread reader([&]()
+	{
+		XEpochGuard guard;
+		::InterlockedExchange(&lState, 1);
+		while (::InterlockedCompareExchange(&lState, 0, 0) != 2)
+		{
+			Sleep(1);
+		}
+	});
+	while (::InterlockedCompareExchange(&lState, 0, 0) != 1)
+	{
+		Sleep(1);
+	}
+
+	// ߻ڣ˳ֻ߳ܰѽڵ
+	std::thread writer([]()
+	{
+		for (int n = 0; n < 5; ++n)
+		{
+			XEpoch::Retire(MCALLOC(32));
+		}
+	});
+	writer.join();
+	XCHECK(XEpoch::Flush() == 0);
+
+	::InterlockedExchange(&lState, 2);
+	reader.join();
+	XCHECK(XEpoch::Flush() == 5);
+}
@@ -0,0 +1,73 @@
+#include "stdafx.h"
+#include "XHistogram.h"
+#include "xtest.h"
+
+//-----------------------------------------------------------------------------
+// 2048ÿֵһ񣬰ٷλǾȷ
+//-----------------------------------------------------------------------------
+XTEST(XHistogram_SmallExact)
+{
+	XHistogram hist;
+	for (unsigned long long n = 1; n <= 1000; ++n)
+	{
+		hist.Record(n);
+	}
+
+	XCHECK(hist.GetTotalCount() == 1000);
+	XCHECK(hist.GetMin() == 1);
+	XCHECK(hist.GetMax() == 1000);
+	XCHECK(hist.GetValueAtPercentile(0.0) == 1);
+	XCHECK(hist.GetValueAtPercentile(50.0) == 500);
+	XCHECK(hist.GetValueAtPercentile(99.0) == 990);
+	XCHECK(hist.GetValueAtPercentile(100.0) == 1000);
+	XCHECK(hist.GetValueAtPercentile(150.0) == 1000);
+	XCHECK(fabs(hist.GetMean() - 500.5) < 1.0);
+}
+
+//-----------------------------------------------------------------------------
+// ֵǧ֮һҲʵֵС
+//-----------------------------------------------------------------------------
+XTEST(XHistogram_LargeRelativeError)
+{
+	XHistogram hist;
+	for (unsigned long long n = 1; n <= 1000000; ++n)
+	{
+		hist.Record(n * 1000);
+	}
+
+	const double dPercentiles[] = { 50.0, 90.0, 99.0, 99.9, 99.99, 100.0 };
+	bool bOk = true;
+	for (size_t i = 0; i < sizeof(dPercentiles) / sizeof(dPercentiles[0]); ++i)
+	{
+		double dExpect = dPercentiles[i] / 100.0 * 1000000 * 1000;
+		double dValue = (double)hist.GetValueAtPercentile(dPercentiles[i]);
+		bOk = bOk && dValue >= dExpect && (dValue - dExpect) / dExpect < 0.001;
+	}
+	XCHECK(bOk);
+}
+
+//-----------------------------------------------------------------------------
+// ϲڷֱ¼Χļǵһ
+//-----------------------------------------------------------------------------
+XTEST(XHistogram_AddAndOverflow)
+{
+	XHistogram a, b;
+	for (unsigned long long n = 1; n <= 500; ++n)
+	{
+		a.Record(n);
+		b.Record(n + 500);
+	}
+	a.Add(b);
+	XCHECK(a.GetTotalCount() == 1000);
+	XCHECK(a.GetValueAtPercentile(50.0) == 500);
+	XCHECK(a.GetMax() == 1000);
+
+	XHistogram c;
+	c.Record(~0ULL);
+	XCHECK(c.GetTotalCount() == 1);
+	XCHECK(c.GetMax() == (1ULL << 42) - 1);
+
+	c.Reset();
+	XCHECK(c.GetTotalCount() == 0);
+	XCHECK(c.GetValueAtPercentile(99.0) == 0);
+}
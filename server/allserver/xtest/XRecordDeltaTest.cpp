@@ -0,0 +1,82 @@
+#include "stdafx.h"
+#include "XRecordDelta.h"
+#include "xtest.h"
+
+namespace
+{
+	enum { EDF_Level, EDF_Name, EDF_Gold, EDF_Exp };
+	typedef XRecordSchema<
+		XFixed<unsigned short>,		// EDF_Level
+		XBytes<8>,					// EDF_Name
+		XVarint<long long>,			// EDF_Gold
+		XVarint<unsigned int>		// EDF_Exp
+	> tagDeltaSchema;
+	typedef XRecordDelta<tagDeltaSchema> tagDelta;
+}
+
+//-----------------------------------------------------------------------------
+// DiffĲ򵽾ɼ¼ϵõ¼¼
+//-----------------------------------------------------------------------------
+XTEST(XRecordDelta_DiffPatch)
+{
+	XRecordWriter<tagDeltaSchema> oldWriter;
+	oldWriter.Set<EDF_Level>(10);
+	oldWriter.Set<EDF_Name>("alice");
+	oldWriter.Set<EDF_Gold>(5);
+	oldWriter.Set<EDF_Exp>(100);
+	unsigned int dwOldSize = oldWriter.Finish();
+
+	XRecordWriter<tagDeltaSchema> newWriter(XRecordView<tagDeltaSchema>(oldWriter.GetData(), dwOldSize));
+	newWriter.Set<EDF_Gold>(-123456789);
+	newWriter.Clear<EDF_Exp>();
+	unsigned int dwNewSize = newWriter.Finish();
+
+	unsigned char byDelta[tagDelta::MAX_SIZE];
+	XRecordView<tagDeltaSchema> oldView(oldWriter.GetData(), dwOldSize);
+	XRecordView<tagDeltaSchema> newView(newWriter.GetData(), dwNewSize);
+	XCHECK(tagDelta::Diff(oldView, oldView, byDelta) == 0);
+
+	unsigned int dwDeltaLen = tagDelta::Diff(oldView, newView, byDelta);
+	XCHECK(dwDeltaLen > 0);
+
+	unsigned char byRecord[tagDeltaSchema::MAX_SIZE];
+	memcpy(byRecord, oldWriter.GetData(), dwOldSize);
+	unsigned int dwSize = tagDelta::Patch(byRecord, sizeof(byRecord), byDelta, dwDeltaLen);
+	XCHECK(dwSize == dwNewSize);
+	XCHECK(memcmp(byRecord, newWriter.GetData(), dwNewSize) == 0);
+
+	XRecordView<tagDeltaSchema> view(byRecord, dwSize);
+	XCHECK(view.Get<EDF_Gold>() == -123456789);
+	XCHECK(!view.Has<EDF_Exp>());
+	XCHECK(strcmp(view.Get<EDF_Name>(), "alice") == 0);
+}
+
+//-----------------------------------------------------------------------------
+// Ϸļ¼ȽϣƻֽڴβĲ첻
+//-----------------------------------------------------------------------------
+XTEST(XRecordDelta_RejectInvalid)
+{
+	XRecordWriter<tagDeltaSchema> writer;
+	writer.Set<EDF_Name>("bob");
+	unsigned int dwSize = writer.Finish();
+	XRecordView<tagDeltaSchema> view(writer.GetData(), dwSize);
+
+	unsigned char byDelta[tagDelta::MAX_SIZE];
+	XCHECK(tagDelta::Diff(XRecordView<tagDeltaSchema>(writer.GetData(), 3), view, byDelta) == 0);
+	XCHECK(tagDelta::Diff(view, XRecordView<tagDeltaSchema>(nullptr, 0), byDelta) == 0);
+
+	XRecordDeltaWriter<tagDeltaSchema> deltaWriter;
+	deltaWriter.Set<EDF_Name>("carol");
+	unsigned int dwDeltaLen = deltaWriter.Finish();
+	memcpy(byDelta, deltaWriter.GetData(), dwDeltaLen);
+	memset(byDelta + tagDelta::VALUE_OFFSET, 'x', 8);	// ֵĽβ0ĵ
+
+	unsigned char byRecord[tagDeltaSchema::MAX_SIZE];
+	memcpy(byRecord, writer.GetData(), dwSize);
+	XCHECK(tagDelta::Patch(byRecord, sizeof(byRecord), byDelta, dwDeltaLen) == 0);
+	XCHECK(memcmp(byRecord, writer.GetData(), dwSize) == 0);
+
+	memcpy(byDelta, deltaWriter.GetData(), dwDeltaLen);
+	XCHECK(tagDelta::Patch(byRecord, sizeof(byRecord), byDelta, dwDeltaLen) == dwSize);
+	XCHECK(strcmp(XRecordView<tagDeltaSchema>(byRecord, dwSize).Get<EDF_Name>(), "carol") == 0);
+}
@@ -0,0 +1,48 @@
+#include "stdafx.h"
+#include "XRecord.h"
+#include "xtest.h"
+
+namespace
+{
+	enum { ETF_ID, ETF_Name, ETF_Gold };
+	typedef XRecordSchema<
+		XFixed<unsigned int>,		// ETF_ID
+		XBytes<8>,					// ETF_Name
+		XVarint<long long>			// ETF_Gold
+	> tagTestSchema;
+}
+
+//-----------------------------------------------------------------------------
+// дֽڴҲ0β
+//-----------------------------------------------------------------------------
+XTEST(XRecord_BytesTerminated)
+{
+	XRecordWriter<tagTestSchema> writer;
+	writer.Set<ETF_ID>(10001);
+	writer.Set<ETF_Name>("abcdefghijk");
+	writer.Set<ETF_Gold>(-500);
+	unsigned int dwSize = writer.Finish();
+
+	XRecordView<tagTestSchema> view(writer.GetData(), dwSize);
+	XCHECK(view.IsValid());
+	XCHECK(view.Get<ETF_ID>() == 10001);
+	XCHECK(strcmp(view.Get<ETF_Name>(), "abcdefg") == 0);
+	XCHECK(view.Get<ETF_Gold>() == -500);
+}
+
+//-----------------------------------------------------------------------------
+// յֽڴûнβ0ʱ¼Ч
+//-----------------------------------------------------------------------------
+XTEST(XRecord_RejectUnterminated)
+{
+	XRecordWriter<tagTestSchema> writer;
+	writer.Set<ETF_Name>("abc");
+	unsigned int dwSize = writer.Finish();
+
+	unsigned char byBuf[tagTestSchema::MAX_SIZE];
+	memcpy(byBuf, writer.GetData(), dwSize);
+	memset(byBuf + tagTestSchema::Field<ETF_Name>::OFFSET, 'x', 8);
+
+	XCHECK(!XRecordView<tagTestSchema>(byBuf, dwSize).IsValid());
+	XCHECK(!XRecordView<tagTestSchema>(byBuf, dwSize - 1).IsValid());
+}
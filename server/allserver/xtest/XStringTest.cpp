@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "XString.h"
+#include "xtest.h"
+
+//-----------------------------------------------------------------------------
+// ̵ķŶڣĴڴط䣬ݺͳȶҪ
+//-----------------------------------------------------------------------------
+XTEST(XSmallString_InlineAndHeap)
+{
+	XSmallString str("short");
+	XCHECK(str.Length() == 5);
+	XCHECK(strcmp(str.c_str(), "short") == 0);
+
+	str.Append(" but now it is longer than inline", 33);
+	XCHECK(str.Length() == 38);
+	XCHECK(strcmp(str.c_str(), "short but now it is longer than inline") == 0);
+
+	XSmallString strCopy(str);
+	XCHECK(strCopy == str);
+	XCHECK(!(strCopy < str) && !(str < strCopy));
+
+	XSmallString strMove(std::move(strCopy));
+	XCHECK(strMove == str);
+	XCHECK(strCopy.Empty());
+}
+
+//-----------------------------------------------------------------------------
+// ԴĶڴʱݺܶͷŵľɻ
+//-----------------------------------------------------------------------------
+XTEST(XSmallString_SelfAppend)
+{
+	XSmallString str("0123456789abcdefghijklmnopqrstuvwxyz");	// 36ڶ
+	str.Append(str.c_str(), str.Length());
+	XCHECK(str.Length() == 72);
+	XCHECK(strcmp(str.c_str(), "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz") == 0);
+
+	str.Append(str.c_str() + 10, 26);
+	XCHECK(str.Length() == 98);
+	XCHECK(strcmp(str.c_str() + 72, "abcdefghijklmnopqrstuvwxyz") == 0);
+
+	XSmallString strShort("abc");
+	strShort.Assign(str.c_str() + 36, 10);
+	XCHECK(strcmp(strShort.c_str(), "0123456789") == 0);
+
+	str.Assign(str.c_str() + 1, 50);
+	XCHECK(str.Length() == 50);
+	XCHECK(strcmp(str.c_str(), "123456789abcdefghijklmnopqrstuvwxyz0123456789abcde") == 0);
+}
+
+//-----------------------------------------------------------------------------
+// Դڶڻ׷Ӻ󳬳ɶڴǰԴܱ
+//-----------------------------------------------------------------------------
+XTEST(XSmallString_SelfAppendInline)
+{
+	XSmallString str("0123456789abcdefghij");	// 20ڶ
+	str.Append(str.c_str(), str.Length());
+	XCHECK(str.Length() == 40);
+	XCHECK(strcmp(str.c_str(), "0123456789abcdefghij0123456789abcdefghij") == 0);
+
+	XSmallString strPart("abcdefghijklmnop");		// 16
+	strPart.Append(strPart.c_str() + 4, 10);
+	XCHECK(strPart.Length() == 26);
+	XCHECK(strcmp(strPart.c_str(), "abcdefghijklmnopefghijklmn") == 0);
+
+	XSmallString strFit("0123456789");				// ׷Ӻڶ
+	strFit.Append(strFit.c_str() + 2, 5);
+	XCHECK(strcmp(strFit.c_str(), "012345678923456") == 0);
+}
+
+//-----------------------------------------------------------------------------
+// ͬݵõͬһ
+//-----------------------------------------------------------------------------
+XTEST(XInternTable_SameHandle)
+{
+	XInternTable<XAtomMutex> table;
+	XCHECK(!table.Find("alice", 5).IsValid());
+
+	XInternKey key = table.Intern("alice");
+	XCHECK(key.IsValid());
+	XCHECK(key == table.Intern(XSmallString("alice")));
+	XCHECK(key == table.Find("alice", 5));
+	XCHECK(key != table.Intern("bob"));
+	XCHECK(strcmp(key.c_str(), "alice") == 0 && key.Length() == 5);
+
+	// ൽҪͰ֮ǰľ
+	char szName[32];
+	for (int n = 0; n < 5000; ++n)
+	{
+		snprintf(szName, sizeof(szName), "player%d", n);
+		table.Intern(szName);
+	}
+	XCHECK(table.GetCount() == 5002);
+	XCHECK(key == table.Find("alice", 5));
+	XCHECK(strcmp(table.Find("player4999", 10).c_str(), "player4999") == 0);
+}
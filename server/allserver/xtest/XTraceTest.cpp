@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "XTrace.h"
+#include "xtest.h"
+#include <string>
+#include <thread>
+
+#define XTRACE_TEST_FILE	"xtest_trace.json"
+
+//-----------------------------------------------------------------------------
+static int XTraceTestCount(const std::string& strText, const char* szPattern)
+{
+	int nCount = 0;
+	for (size_t nPos = strText.find(szPattern); nPos != std::string::npos; nPos = strText.find(szPattern, nPos + 1))
+	{
+		++nCount;
+	}
+	return nCount;
+}
+
+//-----------------------------------------------------------------------------
+// һszPatterntidûз0
+//-----------------------------------------------------------------------------
+static unsigned int XTraceTestTid(const std::string& strText, const char* szPattern)
+{
+	size_t nPos = strText.find(szPattern);
+	if (nPos == std::string::npos)
+	{
+		return 0;
+	}
+
+	size_t nEnd = strText.find('\n', nPos);
+	size_t nBegin = strText.rfind('\n', nPos);
+	std::string strLine = strText.substr(nBegin + 1, nEnd == std::string::npos ? std::string::npos : nEnd - nBegin - 1);
+	size_t nTid = strLine.find("\"tid\":");
+	return nTid == std::string::npos ? 0 : (unsigned int)strtoul(strLine.c_str() + nTid + 6, nullptr, 10);
+}
+
+//-----------------------------------------------------------------------------
+// ̸߳һ¼Dumpjsonÿһ¼߳¼Ե
+//-----------------------------------------------------------------------------
+XTEST(XTrace_DumpTwoThreads)
+{
+	XTrace::SetEnable(true);
+
+	// ߳˳ͷŻ壬Dump˳
+	LONG volatile lReady = 0;
+	LONG volatile lExit = 0;
+	auto worker = [&](const char* szThread, const char* szSpan)
+	{
+		XTRACE_THREAD_NAME(szThread);
+		for (int n = 0; n < 100; ++n)
+		{
+			XTRACE_SCOPE_ARG(szSpan, n);
+		}
+		XTRACE_INSTANT("XTest \"quoted\"");
+		::InterlockedIncrement(&lReady);
+		while (::InterlockedCompareExchange(&lExit, 0, 0) == 0)
+		{
+			Sleep(1);
+		}
+	};
+	std::thread threadA(worker, "XTestTraceA", "XTest::SpanA");
+	std::thread threadB(worker, "XTestTraceB", "XTest::SpanB");
+	while (::InterlockedCompareExchange(&lReady, 0, 0) != 2)
+	{
+		Sleep(1);
+	}
+
+	int nCount = XTrace::Dump(XTRACE_TEST_FILE);
+	XTrace::SetEnable(false);
+	::InterlockedExchange(&lExit, 1);
+	threadA.join();
+	threadB.join();
+
+	std::string strText;
+	FILE* fp = fopen(XTRACE_TEST_FILE, "rb");
+	XCHECK(fp != nullptr);
+	if (fp)
+	{
+		char szBuf[4096];
+		size_t nRead;
+		while ((nRead = fread(szBuf, 1, sizeof(szBuf), fp)) > 0)
+		{
+			strText.append(szBuf, nRead);
+		}
+		fclose(fp);
+	}
+	remove(XTRACE_TEST_FILE);
+
+	// 2߳ + 200 + 2˲ʱ¼ܻ߳̿б¼
+	XCHECK(nCount >= 204);
+	XCHECK(strText.compare(0, 40, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n") == 0);
+	XCHECK(strText.size() > 4 && strText.compare(strText.size() - 4, 4, "\n]}\n") == 0);
+	XCHECK(XTraceTestCount(strText, "\n{\"name\":\"") == nCount);
+
+	XCHECK(XTraceTestCount(strText, "{\"name\":\"XTest::SpanA\",\"ph\":\"X\"") == 100);
+	XCHECK(XTraceTestCount(strText, "{\"name\":\"XTest::SpanB\",\"ph\":\"X\"") == 100);
+	XCHECK(XTraceTestCount(strText, "\"args\":{\"arg\":99}") >= 2);
+	XCHECK(XTraceTestCount(strText, "{\"name\":\"XTest \\\"quoted\\\"\",\"ph\":\"i\"") == 2);
+
+	// ¼̵߳ͬһtid£̵߳tidͬ
+	unsigned int dwTidA = XTraceTestTid(strText, "\"args\":{\"name\":\"XTestTraceA\"}");
+	unsigned int dwTidB = XTraceTestTid(strText, "\"args\":{\"name\":\"XTestTraceB\"}");
+	XCHECK(dwTidA != 0 && dwTidB != 0 && dwTidA != dwTidB);
+	XCHECK(XTraceTestTid(strText, "\"XTest::SpanA\"") == dwTidA);
+	XCHECK(XTraceTestTid(strText, "\"XTest::SpanB\"") == dwTidB);
+}
@@ -0,0 +1,42 @@
+// xtest.cpp : xcommondbserverģΪ
+//
+// xtest [ǰ׺]ȫʧʱ1
+//
+
+#include "stdafx.h"
+#include "XMemCache.h"
+#include "xtest.h"
+
+XMemCache<XAtomMutex>*	g_pMemCache = nullptr;
+
+int main(int argc, char* argv[])
+{
+	g_pMemCache = new XMemCache<XAtomMutex>(64 * 1024 * 1024);
+
+	const char* szFilter = argc > 1 ? argv[1] : "";
+	int nRun = 0, nFailed = 0;
+	for (tagXTestCase* pCase = XTestList(); pCase; pCase = pCase->pNext)
+	{
+		if (strncmp(pCase->szName, szFilter, strlen(szFilter)) != 0)
+		{
+			continue;
+		}
+
+		XTestFailCount() = 0;
+		pCase->pFunc();
+		++nRun;
+
+		if (XTestFailCount())
+		{
+			++nFailed;
+			printf("[FAIL] %s\n", pCase->szName);
+		}
+		else
+		{
+			printf("[ OK ] %s\n", pCase->szName);
+		}
+	}
+
+	printf("%d run, %d failed\n", nRun, nFailed);
+	return nFailed ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef __XTEST_H__
+#define __XTEST_H__
+
+#include "XDeclare.h"
+
+//-----------------------------------------------------------------------------
+// Ĳעͼ飬ÿļXTESTxtest.cpp
+//-----------------------------------------------------------------------------
+typedef void (*XTestFunc)();
+
+struct tagXTestCase
+{
+	const char*		szName;
+	XTestFunc		pFunc;
+	tagXTestCase*	pNext;
+};
+
+//-----------------------------------------------------------------------------
+// ȫע˳
+//-----------------------------------------------------------------------------
+inline tagXTestCase*& XTestList()
+{
+	static tagXTestCase* s_pFirst = nullptr;
+	return s_pFirst;
+}
+
+//-----------------------------------------------------------------------------
+// ǰʧܵļ
+//-----------------------------------------------------------------------------
+inline int& XTestFailCount()
+{
+	static int s_nFail = 0;
+	return s_nFail;
+}
+
+//-----------------------------------------------------------------------------
+class XTestRegistrar
+{
+public:
+	XTestRegistrar(tagXTestCase* pCase)
+	{
+		tagXTestCase** ppLast = &XTestList();
+		while (*ppLast)
+		{
+			ppLast = &(*ppLast)->pNext;
+		}
+		*ppLast = pCase;
+	}
+};
+
+#define XTEST(name)																\
+	static void XTest_##name();													\
+	static tagXTestCase s_XTestCase_##name = { #name, XTest_##name, nullptr };	\
+	static XTestRegistrar s_XTestReg_##name(&s_XTestCase_##name);				\
+	static void XTest_##name()
+
+//-----------------------------------------------------------------------------
+// ʧʱӡλãִ
+//-----------------------------------------------------------------------------
+#define XCHECK(expr)															\
+	do																			\
+	{																			\
+		if (!(expr))															\
+		{																		\
+			printf("  %s(%d): XCHECK(%s) failed\n", __FILE__, __LINE__, #expr);	\
+			++XTestFailCount();													\
+		}																		\
+	} while (0)
+
+#endif // !__XTEST_H__